@@ -1,27 +1,69 @@
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include "pico/stdlib.h"
 #include "pico/binary_info.h"
 #include "hardware/gpio.h"
 #include "hardware/pwm.h"
 #include "hardware/timer.h"
+#include "fixed.h"
 #include "motors.h"
+#include "motion.h"
+#include "control.h"
+#include "pose.h"
+#include "grid.h"
+#include "planner.h"
+#include "vfh.h"
+#include "track.h"
+#include "scheduler.h"
+#include "hsm.h"
+#include "store.h"
+#include "geofence.h"
+#include "routes.h"
+#include "tour.h"
+#include "footprint.h"
+#include "movers.h"
+#include "dock.h"
 #include "dwm1001.h"
 #include "atmega.h"
 #include "weight.h"
 #include "ultrasonic.h"
 #include "ir.h"
-#include "web.h"
+#include "ingest.h"
 
 typedef enum
 {
     RobotState_Idle,
+    RobotState_Mission,             // everything from deliveries coming due until the robot is home again
     RobotState_NavigatingToUser,
-    RobotState_Stuck,
     RobotState_DeliveringPayload,
-    RobotState_NavigatingHome
+    RobotState_WaitingRemoval,      // waiting for the dose to be taken off
+    RobotState_Removed,             // waiting for the cup to be put back
+    RobotState_DeliveryComplete,    // making sure the cup stays put before leaving
+    RobotState_NextStop,            // choosing between the next delivery of the tour and home
+    RobotState_NavigatingHome,
+    RobotState_Docking,             // lining up with the dock on the way in
+    RobotState_Stuck,
+    RobotState_BackingOff,          // reversing away from whatever it's stuck on
+    RobotState_Probing,             // turning on the spot a step at a time, looking for a way through
+    RobotState_FollowingWall,       // following the nearest wall out
+    RobotState_Reporting,           // out of ideas, so asking for help (and waiting before trying again)
+    RobotState_Count
 } RobotState;
 
+typedef enum
+{
+    RobotEvent_ScheduleDue,
+    RobotEvent_Arrived,
+    RobotEvent_Stuck,
+    RobotEvent_Freed,               // a stuck robot has a clear way towards its destination again
+    RobotEvent_Failed,              // a recovery behaviour has run out of things to try
+    RobotEvent_Timeout,             // the current state (or a parent) has been in the state for its timeout
+    RobotEvent_NextStop,            // there's another delivery to make before going home
+    RobotEvent_TourDone,            // every delivery has been made
+    RobotEvent_Count
+} RobotEvent;
+
 typedef enum
 {
     MotionState_Forward,
@@ -39,12 +81,6 @@ typedef enum
     NavigationResult_Stuck
 } NavigationResult;
 
-typedef enum
-{
-    DeliveryState_WaitingRemoval,
-    DeliveryState_Removed,
-    DeliveryState_Complete
-} DeliveryState;
 
 
 /************************************************************************/
@@ -55,52 +91,299 @@ typedef enum
 const char WIFI_NETWORK_NAME[] = "PH1";
 const char WIFI_PASSWORD[] = "12345678";
 
-// Motor speed, in cm/s
-const int SPEED = 40;
+// Top speed in open space, in cm/s (it's slowed from there as obstacles get closer)
+const fix16_t SPEED = FIX16_FROM_INT(45);
+
+// Closest (in mm) an ultrasonic should get to anything before the robot has stopped driving forward
+const long STOP_DISTANCE = 150;
+
+// Braking the speed near obstacles is planned around, in cm/s^2 (half what the motor ramp allows, leaving room for its jerk limit and a frame of latency)
+const fix16_t BRAKING = FIX16_FROM_INT(MOTOR_RAMP_MAX_ACCEL / 2);
+
+// Time to collision (in s) at which the robot starts to slow, and at which it must have stopped driving forward
+const fix16_t TTC_SLOW = FIX16_FROM_FLOAT(2.5);
+const fix16_t TTC_STOP = FIX16_FROM_FLOAT(0.5);
+
+// How often the navigation step is run
+const uint32_t CONTROL_RATE_HZ = 100;
+
+// How often the timing of the control loop is reported
+const long CONTROL_STATS_DURATION = 5000000; // 5s (in us)
+
+// Sweep the motors on startup to rebuild their duty to rpm tables (the wheels must be off the ground)
+const bool CALIBRATE_MOTORS = false;
 
-// How long the robot can be "stopped" before it's considered stuck
-const int STUCK_DURATION = 60000; //1 minute (60s ==> 60,000ms)
+// How long the robot can be "stopped" before it's considered stuck (and starts trying to get itself free)
+const long STUCK_DURATION = 5000000; // 5 seconds (in us)
+
+// How long the robot waits for something moving to get out of its way (before it counts towards being stuck),
+// and how far ahead it looks for something moving that is about to get in its way
+const long YIELD_DURATION = 3000000;    // 3 seconds (in us)
+const long YIELD_LOOKAHEAD = 1000000;   // 1 second (in us)
 
 // How long the weight sensor must be in the same state before it will transition between states
-const int WEIGHT_DURATION = 5000; // 5 seconds
+const long WEIGHT_DURATION = 5000000; // 5 seconds (in us)
+
+// Reset the tare once the empty sensor reads this many atod counts away from it
+const int WEIGHT_TARE_TOLERANCE = 2;
+
+// Formats of the records the app keeps in the store
+const uint8_t HOME_RECORD_VERSION = 1;    // the heading the robot was last parked at, at home
+const uint8_t TARE_RECORD_VERSION = 1;    // the weight sensor's tare
+
+// Time allowed for each recovery behaviour before moving on to the next
+const long RECOVERY_BACK_OFF_DURATION = 3000000;        // 3 seconds (in us)
+const long RECOVERY_PROBE_DURATION = 12000000;          // 12 seconds (in us)
+const long RECOVERY_WALL_FOLLOW_DURATION = 20000000;    // 20 seconds (in us)
+
+// How long to wait after reporting the robot stuck before trying to carry on with the mission
+const long STUCK_RETRY_DURATION = 10000000; // 10 seconds (in us)
+
+// How fast (cm/s) and how long to reverse when backing off
+const fix16_t RECOVERY_SPEED = FIX16_FROM_INT(20);
+const uint32_t RECOVERY_BACK_OFF_MS = 1000;
+
+// Each probe turns ~45 degrees (wheels at 15cm/s on the 30cm track turn at 1 rad/s), 8 of them look all the way around
+const fix16_t RECOVERY_TURN_SPEED = FIX16_FROM_INT(15);
+const uint32_t RECOVERY_PROBE_TURN_MS = 785;
+const int RECOVERY_PROBE_TURNS = 8;
+
+// How long to wait after each manoeuvre for the robot to stop and the sensors to catch up before looking again
+const uint32_t RECOVERY_SETTLE_MS = 300;
+
+// How far (in mm) to keep from the wall while following it, and how hard to turn to keep there (rad/s for every m off)
+const long RECOVERY_WALL_DISTANCE = 300;
+const fix16_t RECOVERY_WALL_GAIN = FIX16_FROM_FLOAT(2.0);
+
+// How far (in mm) following the wall must take the robot from where it got stuck before it counts as escaped
+const long RECOVERY_ESCAPE_DISTANCE = 500;
+
+// How fast to spin on the spot when turning, in rad/s (~86 degrees/s, the wheels move at ~22cm/s)
+const fix16_t TURN_RATE = FIX16_FROM_FLOAT(1.5);
+
+// Fastest to turn while still driving forward when steering towards a waypoint, in rad/s (~29 degrees/s)
+const fix16_t ARC_RATE = FIX16_FROM_FLOAT(0.5);
 
+// Turn on the spot rather than arcing when the waypoint is more than this far off the heading (45 degrees)
+const fix16_t STEER_SPIN_ANGLE = FIX16_FROM_FLOAT(0.785398);
+
+// How hard to turn towards the waypoint while driving, in rad/s for every rad it is off the heading
+const fix16_t STEER_GAIN = FIX16_FROM_FLOAT(1.0);
+
+// How far ahead (in mm) the robot checks it won't drive into a keep out zone, or faster than a slow zone allows
+const long ZONE_LOOKAHEAD = 300;
+
+// Most nodes the planner may expand in a navigation step (so planning can't hold up the control loop)
+const int PLANNER_EXPANSIONS = 64;
+
+// How often the path is checked against the map for new obstacles (and a failed search tried again)
+const long PLAN_CHECK_DURATION = 250000; // 250ms (in us)
+
+// Which way the robot faces when it's at home, in rad counter-clockwise from the UWB x axis
+const fix16_t HOME_HEADING = 0;
+
+// How close (in mm) the robot has to get to where it's going to have arrived
+const long ARRIVAL_DISTANCE = 300;
+
+// Longest the final approach to the dock may take, before settling for wherever it got to
+const long DOCK_DURATION = 30000000; // 30 seconds (in us)
+
+// How often to check on the subsystems while booting, and how long to wait for them all before reporting anyway
+const long BOOT_CHECK_DURATION = 100000;     // 100ms (in us)
+const long BOOT_REPORT_TIMEOUT = 30000000;   // 30 seconds (in us)
+
+// How often to ask the server for deliveries while idle
+const long DELIVERY_POLL_DURATION = 30000000;           // 30 seconds (in us)
+
+// When the server says how long until the next delivery comes due, wait that long (but not so long a change to the
+// schedule goes unnoticed, or so little the server is asked over and over)
+const long DELIVERY_HINT_MIN_DURATION = 1000000;        // 1 second (in us)
+const long DELIVERY_HINT_MAX_DURATION = 600000000;      // 10 minutes (in us)
+
+// How long to wait after asking for deliveries fails, doubled for each failure in a row
+const long DELIVERY_RETRY_DURATION = 5000000;           // 5 seconds (in us)
+const long DELIVERY_RETRY_MAX_DURATION = 300000000;     // 5 minutes (in us)
+
+// How often the user's position is asked for while navigating to them
 const long USER_REQUEST_DURATION = 500000; // 500ms (in us)
-const long ROBOT_REQUEST_DURATION = 20000; // 20ms (in us) (the robot only updates every 100ms but we want to ensure we get the new value fairly accurately)
 
-// monitor current state of motor so instructions are only sent for changes
-volatile MotionState currentRightMotorState = MotionState_ToBeDetermined;
-volatile MotionState currentLeftMotorState = MotionState_ToBeDetermined;
+// what the robot is doing (see robotStates and robotTransitions)
+struct Hsm robot;
+
+// the latest sensor values, the deliveries being made (in the order they're visited) and the schedule being delivered (-1 if none)
+struct AtmegaSensorValues sensorValues;
+struct Tour tour;
+int scheduleId = -1;
+
+// monitor current state of the motors so instructions are only sent for changes
+volatile MotionState currentMotionState = MotionState_ToBeDetermined;
 
 volatile struct DWM1001_Position userPosition;
+
+// the user's recent positions, to predict where they are between updates
+struct Track userTrack;
+
+// what each ultrasonic sees and how fast it is getting closer
+struct Ultrasonic_Track ultrasonicTracks[3];
 volatile struct DWM1001_Position robotPosition;
 
-volatile long next_robot_request = ROBOT_REQUEST_DURATION;
+// set while core 1 is checking for deliveries for us, so we don't keep asking
+volatile bool scheduleCheckRequested = 0;
+
+// raised by the scheduler when it's time to check for deliveries again, and how long the last wait after a failure was
+// (0 if the last check worked)
+volatile bool deliveryCheckDue = 0;
+int deliveryCheckTask = -1;
+long deliveryRetry = 0;
+
+// periodic and timed work on core 0 (run in between navigation steps)
+struct Scheduler scheduler;
+int userRequestTask = -1;
+int bootTask = -1;
+
+// when each of core 0's subsystems came up (us since boot), core 1 reports its own
+uint64_t storeReady = 0;
+uint64_t motorsReady = 0;
+uint64_t ingestLaunched = 0;
+uint64_t mapReady = 0;
+int stuckTimer = -1;
+int yieldTimer = -1;
+
+// 1 if a route has been recorded since the routes were last saved, and the planner cell the current leg started in (-1 if unknown)
+bool routesChanged = 0;
+int legStartCell = -1;
+
+// the waypoint navigation was last heading for, and how the current recovery is going
+struct PlannerWaypoint navigationTarget;
+struct Recovery {
+    long stuckX;        // mm, where the robot got stuck
+    long stuckY;
+    bool settled;       // the last manoeuvre has finished and the robot has been given time to settle
+    int turns;          // probe turns made
+    Motion_TurnDirection turnDirection;
+    Ultrasonic_Device wallSide;
+} recovery;
+
+// when the centre ultrasonic's range was last taken into the docking estimate
+uint64_t dockRangeTime = 0;
+
+// raised by the scheduler for the navigation step to act on
+volatile bool planCheckDue = 0;
+volatile bool stuckDetected = 0;
+volatile bool yieldExpired = 0;
 
 /************************************************************************/
 /* Local Definitions (private functions)                                */
 /************************************************************************/
 
-int idle(void);
+bool idle(void);
 NavigationResult navigating_to_user(struct AtmegaSensorValues sensorValues);
-bool delivering_payload(struct AtmegaSensorValues sensorValues, int scheduleId);
 NavigationResult navigating_home(struct AtmegaSensorValues sensorValues);
-MotionState interpret_sensors(struct AtmegaSensorValues sensorValues);
 NavigationResult navigate(struct AtmegaSensorValues sensorValues, struct DWM1001_Position destination);
-void act_on_motion_state(MotionState action);
 void turn_right();
 void turn_left();
 void go_forward();
 void go_backward();
 void stop();
-bool has_duration_passed(uint64_t snapshot, uint64_t duration);
+void arc(fix16_t linear, fix16_t angular);
+void steer_towards(fix16_t error, fix16_t speed);
+struct PlannerWaypoint plan_route(struct DWM1001_Position destination);
+void start_route(struct Pose pose, struct DWM1001_Position destination);
+void update_pose(struct AtmegaSensorValues sensorValues, bool newFrame);
+void map_ultrasonics(struct AtmegaSensorValues sensorValues);
+void sense_obstacles(struct AtmegaSensorValues sensorValues);
+void track_ultrasonic(Ultrasonic_Device device, long duration);
+fix16_t obstacle_speed(void);
+fix16_t zone_speed(void);
+fix16_t footprint_speed(fix16_t speed, fix16_t angular);
+fix16_t drive_speed(struct VfhChoice choice, fix16_t error);
+fix16_t steer_rate(fix16_t error);
+fix16_t wheel_velocity(bool forward, char rpm);
+void raise_flag(void * flag);
+void request_user_location(void * data);
+void report_control_stats(void * data);
+void check_boot(void * data);
+void print_ready(const char * name, uint64_t ready, uint64_t previous);
+int read_motor_rpm(Motor motor);
+void run_background_tasks(void);
+void idle_entry(void);
+void idle_exit(void);
+void idle_during(void);
+long delivery_check_delay(const struct IngestDeliveries * deliveries);
+void mission_entry(void);
+void navigating_to_user_entry(void);
+void navigating_to_user_exit(void);
+void navigating_to_user_during(void);
+void navigating_home_entry(void);
+void navigating_home_during(void);
+void docking_entry(void);
+void docking_during(void);
+void navigation_result(NavigationResult result);
+void delivering_entry(void);
+void await_load(void);
+void log_delivery(void);
+void next_stop_during(void);
+void stuck_entry(void);
+void record_tare(void);
+void save_home(void);
+void load_stored(void);
+void back_off_entry(void);
+void back_off_during(void);
+void probe_entry(void);
+void probe_during(void);
+void follow_wall_entry(void);
+void follow_wall_during(void);
+void report_entry(void);
+void report_during(void);
+bool recovery_settled(void);
+bool recovery_way_clear(void);
+bool way_blocked(struct VfhChoice choice, fix16_t error, fix16_t speed, bool dropImminent);
 
-int main() {
-    RobotState robotState = RobotState_Idle;
-    int scheduleId = -1; //may be populated during operation if a schedule is operating
+// (name, parent, initial child, timeout, entry, exit, during)
+const struct HsmState robotStates[RobotState_Count] = {
+    [RobotState_Idle]               = {"idle", HSM_NONE, HSM_NONE, NULL, idle_entry, idle_exit, idle_during},
+    [RobotState_Mission]            = {"mission", HSM_NONE, RobotState_NavigatingToUser, NULL, mission_entry, NULL, NULL},
+    [RobotState_NavigatingToUser]   = {"navigating to user", RobotState_Mission, HSM_NONE, NULL, navigating_to_user_entry, navigating_to_user_exit, navigating_to_user_during},
+    [RobotState_DeliveringPayload]  = {"delivering", RobotState_Mission, RobotState_WaitingRemoval, NULL, delivering_entry, NULL, NULL},
+    [RobotState_WaitingRemoval]     = {"waiting removal", RobotState_DeliveringPayload, HSM_NONE, &WEIGHT_DURATION, NULL, NULL, await_load},
+    [RobotState_Removed]            = {"removed", RobotState_DeliveringPayload, HSM_NONE, &WEIGHT_DURATION, NULL, NULL, await_load},
+    [RobotState_DeliveryComplete]   = {"delivery complete", RobotState_DeliveringPayload, HSM_NONE, &WEIGHT_DURATION, NULL, NULL, await_load},
+    [RobotState_NextStop]           = {"next stop", RobotState_Mission, HSM_NONE, NULL, NULL, NULL, next_stop_during},
+    [RobotState_NavigatingHome]     = {"navigating home", RobotState_Mission, HSM_NONE, NULL, navigating_home_entry, NULL, navigating_home_during},
+    [RobotState_Docking]            = {"docking", RobotState_Mission, HSM_NONE, &DOCK_DURATION, docking_entry, NULL, docking_during},
+    [RobotState_Stuck]              = {"stuck", HSM_NONE, RobotState_BackingOff, NULL, stuck_entry, NULL, NULL},
+    [RobotState_BackingOff]         = {"backing off", RobotState_Stuck, HSM_NONE, &RECOVERY_BACK_OFF_DURATION, back_off_entry, NULL, back_off_during},
+    [RobotState_Probing]            = {"probing", RobotState_Stuck, HSM_NONE, &RECOVERY_PROBE_DURATION, probe_entry, NULL, probe_during},
+    [RobotState_FollowingWall]      = {"following wall", RobotState_Stuck, HSM_NONE, &RECOVERY_WALL_FOLLOW_DURATION, follow_wall_entry, NULL, follow_wall_during},
+    [RobotState_Reporting]          = {"reporting", RobotState_Stuck, HSM_NONE, &STUCK_RETRY_DURATION, report_entry, NULL, report_during}
+};
 
-    // Navigating state variables
-    struct AtmegaSensorValues sensorValues;
+// (state, event ==> target, history, action)
+const struct HsmTransition robotTransitions[] = {
+    {RobotState_Idle, RobotEvent_ScheduleDue, RobotState_Mission, 0, NULL},
+    {RobotState_Mission, RobotEvent_Stuck, RobotState_Stuck, 0, NULL},
+    {RobotState_NavigatingToUser, RobotEvent_Arrived, RobotState_DeliveringPayload, 0, NULL},
+    {RobotState_WaitingRemoval, RobotEvent_Timeout, RobotState_Removed, 0, record_tare},
+    {RobotState_Removed, RobotEvent_Timeout, RobotState_DeliveryComplete, 0, NULL},
+    {RobotState_DeliveryComplete, RobotEvent_Timeout, RobotState_NextStop, 0, log_delivery},
+    {RobotState_NextStop, RobotEvent_NextStop, RobotState_NavigatingToUser, 0, NULL},
+    {RobotState_NextStop, RobotEvent_TourDone, RobotState_NavigatingHome, 0, NULL},
+    {RobotState_NavigatingHome, RobotEvent_Arrived, RobotState_Docking, 0, NULL},
+    {RobotState_Docking, RobotEvent_Arrived, RobotState_Idle, 0, save_home},
+    {RobotState_Docking, RobotEvent_Timeout, RobotState_Idle, 0, save_home},
+    // each recovery behaviour hands on to the next when it gives up or runs out of time
+    {RobotState_BackingOff, RobotEvent_Failed, RobotState_Probing, 0, NULL},
+    {RobotState_BackingOff, RobotEvent_Timeout, RobotState_Probing, 0, NULL},
+    {RobotState_Probing, RobotEvent_Failed, RobotState_FollowingWall, 0, NULL},
+    {RobotState_Probing, RobotEvent_Timeout, RobotState_FollowingWall, 0, NULL},
+    {RobotState_FollowingWall, RobotEvent_Failed, RobotState_Reporting, 0, NULL},
+    {RobotState_FollowingWall, RobotEvent_Timeout, RobotState_Reporting, 0, NULL},
+    // pick the mission back up wherever it was left, once free (or after waiting for help)
+    {RobotState_Stuck, RobotEvent_Freed, RobotState_Mission, 1, NULL},
+    {RobotState_Reporting, RobotEvent_Timeout, RobotState_Mission, 1, NULL}
+};
 
+int main() {
     // initialize robot position
     robotPosition.x = 0;
     robotPosition.y = 0;
@@ -115,55 +398,66 @@ int main() {
     
     stdio_init_all();
 
-    dwm1001_init_communication();
-    atmega_init_communication();
+    // (the motors load their calibration from the store, and core 1 can't be running yet if it has to be moved into it)
+    store_init();
+    storeReady = time_us_64();
     motor_init_all();
+    motorsReady = time_us_64();
+
+    // core 1 takes care of the atmega, DWM1001 and the web server (including connecting to wifi)
+    ingest_launch(WIFI_NETWORK_NAME, WIFI_PASSWORD, "Arven");
+    ingestLaunched = time_us_64();
+
+    if(CALIBRATE_MOTORS)
+    {
+        int motor;
+        for(motor = 0; motor < MOTOR_COUNT; ++motor)
+            motor_calibrate(motor, read_motor_rpm);
+        motor_calibration_save();
+    }
+
+    track_reset(&userTrack);
+    load_stored();
+    vfh_clear();
+    footprint_init();
+    movers_clear();
+    mapReady = time_us_64();
 
-    // wait 2seconds to allow debugging connection
-    sleep_ms(2000);
+    scheduler_init(&scheduler);
+    scheduler_add(&scheduler, "control stats", time_us_64() + CONTROL_STATS_DURATION, CONTROL_STATS_DURATION, report_control_stats, NULL);
+    bootTask = scheduler_add(&scheduler, "boot", time_us_64(), BOOT_CHECK_DURATION, check_boot, NULL);
+    scheduler_add(&scheduler, "plan check", time_us_64() + PLAN_CHECK_DURATION, PLAN_CHECK_DURATION, raise_flag, (void *) &planCheckDue);
 
-    web_init(WIFI_NETWORK_NAME, WIFI_PASSWORD, "Arven", NULL, NULL, NULL);
+    hsm_init(&robot, robotStates, RobotState_Count, robotTransitions, sizeof(robotTransitions) / sizeof(robotTransitions[0]),
+        RobotState_Idle, RobotEvent_Timeout);
+
+    control_loop_init(CONTROL_RATE_HZ);
 
     while (true) 
     {
-        if (robotState == RobotState_NavigatingHome ||
-            robotState == RobotState_DeliveringPayload ||
-            robotState == RobotState_NavigatingToUser)
+        // the navigation step runs at a fixed rate, the time in between is left for everything else
+        if(!control_loop_ready())
         {
-            // get the frame info from the atmega
-            // TODO: We should toggle control of the atmega code detecting the sensors based on if we want data
-            sensorValues = atmega_retrieve_sensor_values();
+            run_background_tasks();
+            // there's nothing to do between steps while idle, so sleep until the next one rather than spinning
+            if(hsm_in_state(&robot, RobotState_Idle))
+                control_loop_wait();
+            continue;
         }
 
-        NavigationResult result;
+        control_loop_step_begin();
 
-        switch(robotState)
+        if(!hsm_in_state(&robot, RobotState_Idle))
         {
-            case RobotState_Idle:
-                scheduleId = idle();
-                if(scheduleId != -1)
-                    // robotState = RobotState_DeliveringPayload;
-                    robotState = RobotState_NavigatingToUser;
-                break;
-            case RobotState_NavigatingToUser:
-                result = navigating_to_user(sensorValues);
-                if(result == NavigationResult_Complete)
-                    robotState = RobotState_DeliveringPayload;
-                else if (result == NavigationResult_Stuck)
-                    robotState = RobotState_Stuck;
-                break;
-            case RobotState_DeliveringPayload:
-                if(delivering_payload(sensorValues, scheduleId))
-                    robotState = RobotState_NavigatingHome;
-                break;
-            case RobotState_NavigatingHome:
-                result = navigating_home(sensorValues);
-                if(result == NavigationResult_Complete)
-                    robotState = RobotState_Idle;
-                else if (result == NavigationResult_Stuck)
-                    robotState = RobotState_Stuck;
-                break;
+            // get the latest frame info from the atmega (as published by core 1)
+            // TODO: We should toggle control of the atmega code detecting the sensors based on if we want data
+            bool newFrame = ingest_take_sensor_values(&sensorValues);
+            update_pose(sensorValues, newFrame);
         }
+
+        hsm_step(&robot);
+
+        control_loop_step_end();
     }
 }
 
@@ -171,375 +465,1005 @@ int main() {
 /* Local  Implementation                                                */
 /************************************************************************/
 
-int idle(void)
+bool idle(void)
 {
-    web_request_check_schedule();
-    // capture the schedule id once the web request has finished
-    return web_response_check_schedule();
+    struct IngestDeliveries deliveries;
+
+    // when the check comes due, ask core 1 for every delivery that's due and wait for it to give us the result
+    if(deliveryCheckDue && !scheduleCheckRequested)
+    {
+        scheduleCheckRequested = ingest_request(Ingest_Command_GetDeliveries, 0);
+        deliveryCheckDue = !scheduleCheckRequested;
+        return 0;
+    }
+    if(!scheduleCheckRequested || !ingest_take_deliveries(&deliveries))
+        return 0;
+
+    scheduleCheckRequested = 0;
+    if(deliveries.received && deliveries.tour.count > 0)
+    {
+        deliveryRetry = 0;
+        tour = deliveries.tour;
+        return 1;
+    }
+
+    // nothing to do yet, so check again later
+    long delay = delivery_check_delay(&deliveries);
+    printf("\nno deliveries%s, checking again in %ld ms", deliveries.received ? "" : " (request failed)", delay / 1000);
+    deliveryCheckTask = scheduler_add(&scheduler, "deliveries", time_us_64() + delay, 0, raise_flag, (void *) &deliveryCheckDue);
+    return 0;
 }
 
-NavigationResult navigating_to_user(struct AtmegaSensorValues sensorValues)
+long delivery_check_delay(const struct IngestDeliveries * deliveries)
 {
-    // get the user's position every 500ms
-    if(!userPosition.set || time_us_64() % USER_REQUEST_DURATION == 0) {
-        web_request_get_user_location();
+    // wait twice as long after each failure in a row, so a server (or wifi) that's down isn't asked over and over
+    if(!deliveries->received)
+    {
+        deliveryRetry = deliveryRetry == 0 ? DELIVERY_RETRY_DURATION : deliveryRetry * 2;
+        if(deliveryRetry > DELIVERY_RETRY_MAX_DURATION)
+            deliveryRetry = DELIVERY_RETRY_MAX_DURATION;
+        return deliveryRetry;
     }
-    struct DWM1001_Position position = web_response_get_user_location();
 
-    if(position.set)
+    deliveryRetry = 0;
+    if(deliveries->next_due < 0)
+        return DELIVERY_POLL_DURATION;
+
+    // wake up for when the server says the next delivery comes due (s, so compared before it's turned into us)
+    if(deliveries->next_due >= DELIVERY_HINT_MAX_DURATION / 1000000)
+        return DELIVERY_HINT_MAX_DURATION;
+    if(deliveries->next_due * 1000000 < DELIVERY_HINT_MIN_DURATION)
+        return DELIVERY_HINT_MIN_DURATION;
+    return deliveries->next_due * 1000000;
+}
+
+NavigationResult navigating_to_user(struct AtmegaSensorValues sensorValues)
+{
+    // (the scheduler asks core 1 for the user's position every 500ms)
+    struct DWM1001_Position position;
+
+    if(ingest_take_user_position(&position))
     {
         userPosition.x = position.x;
         userPosition.y = position.y;
         userPosition.z = position.z;
         userPosition.set = position.set;
+        track_add_fix(&userTrack, position.x, position.y, time_us_64());
         
         printf("\nuserPosition: x:%d y:%d z:%d", userPosition.x, userPosition.y, userPosition.z);
     }
 
-    return navigate(sensorValues, userPosition);
+    // head for where the user should be by now, rather than where they were at the last update
+    struct DWM1001_Position destination;
+    destination.x = userPosition.x;
+    destination.y = userPosition.y;
+    destination.z = userPosition.z;
+    destination.set = userPosition.set;
+    if(destination.set)
+        track_predict(&userTrack, time_us_64(), &destination.x, &destination.y);
+
+    return navigate(sensorValues, destination);
 }
 
 NavigationResult navigating_home(struct AtmegaSensorValues sensorValues)
 {
+    // (only as far as the start of the approach to the dock, docking takes it from there)
     struct DWM1001_Position homePosition;
-    homePosition.x = 0;
-    homePosition.y = 0;
+    dock_staging_point(0, 0, HOME_HEADING, &homePosition.x, &homePosition.y);
     homePosition.z = 0;
     homePosition.set = 1;
 
     return navigate(sensorValues, homePosition);
 }
 
-bool delivering_payload(struct AtmegaSensorValues sensorValues, int scheduleId)
+NavigationResult navigate(struct AtmegaSensorValues sensorValues, struct DWM1001_Position destinationPosition)
 {
-    static DeliveryState state = DeliveryState_WaitingRemoval;
-    static uint64_t loadStateSnapshot = 0;
-    bool complete = 0;
-    // Check if we currently have something on the weight sensor
-    Weight_LoadState loadState = Weight_CheckForLoad(sensorValues.Weight); 
+    NavigationResult result = NavigationResult_Incomplete;
 
-    // take asnapshot of the current time if the snapshot is 0
-    if(loadStateSnapshot == 0)
-        loadStateSnapshot = time_us_64();
+    // Check if the ground (60mm -- 6cm) is still there, the robot can still turn on the spot if it isn't
+    bool dropImminent = IR_CheckForDrop(sensorValues.IR_L_Distance, 60) || IR_CheckForDrop(sensorValues.IR_R_Distance, 60);
 
-    switch(state)
+    // a timed manoeuvre is still running, let it finish unless it's about to drive off an edge
+    if(!motion_is_done())
     {
-        case DeliveryState_WaitingRemoval:
-            if(loadState == Weight_LoadNotPresent)
-            {
-                if(has_duration_passed(loadStateSnapshot, WEIGHT_DURATION))
-                {
-                    state = DeliveryState_Removed;
-                }
-            }
-            else
+        if(!dropImminent)
+            return result;
+        motion_cancel();
+    }
+
+    if(robotPosition.set && destinationPosition.set)
+    {
+        long xDiff = robotPosition.x - destinationPosition.x;
+        long yDiff = robotPosition.y - destinationPosition.y;
+        printf("\nxDiff: %d, yDiff: %d", xDiff, yDiff);
+        //long zDiff = robotPosition.z - destinationPosition.z;
+        // still further than the arrival distance away (in any direction)
+        if(xDiff * xDiff + yDiff * yDiff >= ARRIVAL_DISTANCE * ARRIVAL_DISTANCE)
+        {
+            // follow the planned path, steering around whatever is close by on the way
+            struct PlannerWaypoint target = plan_route(destinationPosition);
+            navigationTarget = target;
+            struct Pose pose = pose_get();
+            struct VfhChoice choice = vfh_choose(fix16_atan2(target.y - pose.y, target.x - pose.x));
+            fix16_t error = fix16_wrap_angle(choice.heading - pose.heading);
+
+            fix16_t speed = drive_speed(choice, error);
+            // give way to anything moving that's in the way (or about to be), for a while at least
+            bool yielding = !yieldExpired && movers_in_way(pose.x, pose.y, pose.heading, time_us_64(), YIELD_LOOKAHEAD);
+
+            if(yielding)
             {
-                // reset the snapshot to re-check later
-                loadStateSnapshot = 0;
+                // waiting for it to pass isn't being stuck, and the way is still planned through where it is
+                if(!scheduler_pending(&scheduler, yieldTimer))
+                    yieldTimer = scheduler_add(&scheduler, "yield", time_us_64() + YIELD_DURATION, 0, raise_flag, (void *) &yieldExpired);
+                stop();
             }
-            break;
-        case DeliveryState_Removed:
-            if(loadState == Weight_LoadPresent)
+            else if(way_blocked(choice, error, speed, dropImminent))
             {
-                if(has_duration_passed(loadStateSnapshot, WEIGHT_DURATION))
-                {
-                    state = DeliveryState_Complete;
-                }
+                // if this is the first time we stopped, start timing how long we stay stopped
+                if(!stuckDetected && !scheduler_pending(&scheduler, stuckTimer))
+                    stuckTimer = scheduler_add(&scheduler, "stuck", time_us_64() + STUCK_DURATION, 0, raise_flag, (void *) &stuckDetected);
+
+                stop();
+                // if we've been stopped for our cutoff duration, we're stuck!
+                if(stuckDetected)
+                    result = NavigationResult_Stuck;
             }
             else
             {
-                // reset the snapshot to re-check later
-                loadStateSnapshot = 0;
-            }
-            break;
-        case DeliveryState_Complete:
-            if(loadState == Weight_LoadPresent)
-            {
-                if(has_duration_passed(loadStateSnapshot, WEIGHT_DURATION))
-                {
-                    printf("\ndose taken");
-                    state = DeliveryState_WaitingRemoval;
-                    web_request_log_delivery(scheduleId);
-                    complete = 1;
-                }
+                // moving again, so the timing starts over next time we stop
+                scheduler_cancel(&scheduler, stuckTimer);
+                stuckDetected = 0;
+                scheduler_cancel(&scheduler, yieldTimer);
+                yieldExpired = 0;
+                steer_towards(error, speed);
             }
-            else
+        }
+        else
+        {
+            // remember the way here, so the next trip between the same places can skip the search
+            // (a path replanned along the way only starts where that replan did, so it isn't the whole trip)
+            struct PlannerPath path;
+            if(planner_get_path(&path) && path.start == legStartCell)
             {
-                // reset the snapshot to re-check later
-                loadStateSnapshot = 0;
+                routes_record(&path);
+                routesChanged = 1;
             }
-            break;
-    }
 
-    return complete;
+            result = NavigationResult_Complete;
+            planner_reset();
+            stop();
+        }
+    }
+    return result;
 }
 
-NavigationResult navigate(struct AtmegaSensorValues sensorValues, struct DWM1001_Position destinationPosition)
+void turn_right()
 {
-    NavigationResult result = NavigationResult_Incomplete;
-    static uint64_t stoppedSnapshot = 0;
-    static long lastXDiff = 0;
-    static long lastYDiff = 0;
-    
-    MotionState state = interpret_sensors(sensorValues);
-    if(state == MotionState_Stop)
+    if(currentMotionState != MotionState_TurnRight)
     {
-        // if this is the first time we stopped, capture the current time for comparison later
-        if(stoppedSnapshot == 0)
-            stoppedSnapshot = time_us_64();
+        printf("\nturn right");
+        motor_set_twist(0, -TURN_RATE);
+        currentMotionState = MotionState_TurnRight;
+    }
+}
 
-        stop();
-        // if the amountof time passed since we first snapped the stopped state has reached our cutoff duration, we're stuck!
-        if(has_duration_passed(stoppedSnapshot, STUCK_DURATION))
-            result = NavigationResult_Stuck;
+void turn_left()
+{
+    if(currentMotionState != MotionState_TurnLeft)
+    {
+        printf("\nturn left");
+        motor_set_twist(0, TURN_RATE);
+        currentMotionState = MotionState_TurnLeft;
     }
-    else
+}
+
+void go_forward()
+{
+    if(currentMotionState != MotionState_Forward)
     {
-        //reset the stopped snapshot so it can be reinitialized later
-        stoppedSnapshot = 0;
-        
-        if(!robotPosition.set || time_us_64() >= next_robot_request)
-        {
-            // rearm to request again
-            next_robot_request = time_us_64() + ROBOT_REQUEST_DURATION;
+        printf("\ngo forward");
+        motor_set_twist(SPEED, 0);
+        currentMotionState = MotionState_Forward;
+    }
+}
 
-            struct DWM1001_Position position = dwm1001_request_position();
+void go_backward()
+{
+    if(currentMotionState != MotionState_Reverse)
+    {
+        printf("\ngo backward");
+        motor_set_twist(-SPEED, 0);
+        currentMotionState = MotionState_Reverse;
+    }
+}
 
-            if(position.set)
-            {
-                robotPosition.x = position.x;
-                robotPosition.y = position.y;
-                robotPosition.z = position.z;
-                robotPosition.set = position.set;
+void stop()
+{
+    if(currentMotionState != MotionState_Stop)
+    {
+        printf("\nstop");
+        motor_stop_all();
+        currentMotionState = MotionState_Stop;
+    }
+}
 
-                printf("\nrobotPosition: x:%d y:%d z:%d", robotPosition.x, robotPosition.y, robotPosition.z);
-            }
-        }
-        
-        if(robotPosition.set && destinationPosition.set)
-        {
-            long xDiff = robotPosition.x - destinationPosition.x;
-            long yDiff = robotPosition.y - destinationPosition.y;
-            printf("\nxDiff: %d, yDiff: %d", xDiff, yDiff);
-            //long zDiff = robotPosition.z - destinationPosition.z;
-            //basically we would want to find the difference between the two points, so
-            //we would take the absolute value of the difference between the two since we
-            //don't care about magnitude when it comes to how close they are to each other
-            if (robotPosition.set && destinationPosition.set && 
-               abs(xDiff) >= 300 || abs(yDiff) >= 300)
-            {
-                switch(state)
-                {
-                    case MotionState_Reverse:
-                    case MotionState_TurnRight:
-                    case MotionState_TurnLeft:
-                        act_on_motion_state(state);
-                        break;
-                    case MotionState_ToBeDetermined:
-                        //TODO: Decide what this should do
-                        if(xDiff < 0){
-                            turn_right();
-                        } else{
-                            turn_left();
-                        }   
-                    case MotionState_Forward: 
-                        // we got further away, so turn around
-                        if(xDiff > lastXDiff) {
-                            // turn right for 5 ms
-                            turn_right();
-                            sleep_ms(5);
-                            // then go forward
-                            act_on_motion_state(state);
-                        // we got closer, so keep going
-                        } else if(xDiff < lastXDiff ) {
-                            act_on_motion_state(state);
-                        }  //TODO: React to y diff 
-                        else
-                        {
-                            act_on_motion_state(state);
-                        }    
-                        break;
-                }
-                lastXDiff = xDiff;
-                lastYDiff = yDiff;
-            }
-            else
-            {
-                result = NavigationResult_Complete;
-                stop();
-            }
-        }
-    }   
-    return result;
+void arc(fix16_t linear, fix16_t angular)
+{
+    // (no print, this is sent every step while steering)
+    motor_set_twist(linear, angular);
+    // an arc isn't one of the tracked states, so make sure the next instruction is always sent
+    currentMotionState = MotionState_ToBeDetermined;
 }
 
-void act_on_motion_state(MotionState action)
+void steer_towards(fix16_t error, fix16_t speed)
 {
-    switch(action)
+    if(error > STEER_SPIN_ANGLE)
     {
-        case MotionState_Forward:
-            go_forward();
-            break;
-        case MotionState_Reverse:
-            go_backward();
-            break;
-        case MotionState_TurnRight:
-            turn_right();
-            break;
-        case MotionState_TurnLeft:
-            turn_left();
-            break;
+        turn_left();
+    }
+    else if(error < -STEER_SPIN_ANGLE)
+    {
+        turn_right();
+    }
+    else
+    {
+        arc(speed, steer_rate(error));
     }
 }
 
-MotionState interpret_sensors(struct AtmegaSensorValues sensorValues)
+fix16_t steer_rate(fix16_t error)
 {
-    MotionState action = MotionState_ToBeDetermined;
+    fix16_t angular = fix16_mul(error, STEER_GAIN);
+    if(angular > ARC_RATE)
+        angular = ARC_RATE;
+    else if(angular < -ARC_RATE)
+        angular = -ARC_RATE;
+    return angular;
+}
 
-    // check if there is an obstacle within 30cm
-    bool obstacleLeft = Ultrasonic_CheckForObstacle(sensorValues.Ultrasonic_L_Duration, 30);
-    bool obstacleCentre = Ultrasonic_CheckForObstacle(sensorValues.Ultrasonic_C_Duration, 30);
-    bool obstacleRight = Ultrasonic_CheckForObstacle(sensorValues.Ultrasonic_R_Duration, 30);
+struct PlannerWaypoint plan_route(struct DWM1001_Position destination)
+{
+    struct Pose pose = pose_get();
+    struct PlannerWaypoint target;
+    Planner_Status status = planner_get_status();
 
-    // Check if the ground (60mm -- 6cm) is still there
-    bool dropImminentLeft = IR_CheckForDrop(sensorValues.IR_L_Distance, 60); 
-    bool dropImminentRight = IR_CheckForDrop(sensorValues.IR_R_Distance, 60);
+    // plan again if there's no path yet or the destination has moved
+    if(status == Planner_Status_Idle || planner_goal_moved(destination.x, destination.y))
+    {
+        // a new leg, so note where it started
+        if(status == Planner_Status_Idle && !planner_cell_from_position(pose.x, pose.y, &legStartCell))
+            legStartCell = -1;
+        start_route(pose, destination);
+    }
+    // and every so often if the search failed (the map may have filled in since) or something has shown up in the way
+    else if(planCheckDue)
+    {
+        planCheckDue = 0;
+        if(status == Planner_Status_NoPath || planner_path_blocked())
+            planner_start(pose.x, pose.y, destination.x, destination.y);
+    }
 
-    // Check if any of the backup sensors are being pressed
-    bool obstacleRear = sensorValues.Bump_L || sensorValues.Bump_R;    
+    planner_step(PLANNER_EXPANSIONS);
 
-    if(dropImminentLeft || dropImminentRight)
+    // head straight for the destination until there's a path to follow
+    if(!planner_next_waypoint(pose.x, pose.y, &target))
     {
-        action = MotionState_Stop;
-        //TODO: We may want to backup/turn if only one has a drop pending  
-        //TODO: If we sit here too long, report a failed delivery         
+        target.x = destination.x;
+        target.y = destination.y;
     }
-    // no drop, proceed to check other sensors
+    return target;
+}
+
+void start_route(struct Pose pose, struct DWM1001_Position destination)
+{
+    int startCell, goalCell;
+    struct PlannerPath path;
+
+    // go the way the robot went last time if it's still clear, rather than searching again
+    if(planner_cell_from_position(pose.x, pose.y, &startCell) && planner_cell_from_position(destination.x, destination.y, &goalCell)
+        && routes_find(startCell, goalCell, &path))
+        planner_follow(pose.x, pose.y, destination.x, destination.y, &path);
     else
+        planner_start(pose.x, pose.y, destination.x, destination.y);
+}
+
+void update_pose(struct AtmegaSensorValues sensorValues, bool newFrame)
+{
+    // the wheels are read every step, the speeds are held between frames
+    fix16_t left = wheel_velocity(sensorValues.Motor_FL_Direction, sensorValues.Motor_FL_Speed);
+    fix16_t right = wheel_velocity(sensorValues.Motor_FR_Direction, sensorValues.Motor_FR_Speed);
+    pose_update_odometry(left, right, FIX16_ONE / CONTROL_RATE_HZ);
+
+    // core 1 keeps polling the DWM1001, so just pick up the latest position it has read
+    struct DWM1001_Position position;
+
+    if(ingest_take_robot_position(&position))
     {
-        // no obstacles in front, so go forward
-        if(!obstacleCentre && !obstacleLeft && !obstacleRight) 
-        {
-            // printf("\nno obstacles");
-            action = MotionState_Forward; 
-        } 
-        // obstacle to the left, so turn right (regardless of front)
-        else if(obstacleLeft && !obstacleRight)
-        {
-            //  printf("\nleft obstacle");
-            action = MotionState_TurnRight;
-        }
-        // obstacle to the right, so turn left (regardless of front)
-        else if (obstacleRight && !obstacleLeft)
-        {
-            // printf("\nright obstacle");
-            action = MotionState_TurnLeft;
-        }
-        // just an obstacle in front, so turn towards the destination
-        else if (obstacleCentre && !obstacleRight && !obstacleLeft)
+        robotPosition.x = position.x;
+        robotPosition.y = position.y;
+        robotPosition.z = position.z;
+        robotPosition.set = position.set;
+        pose_update_position(position.x, position.y);
+
+        printf("\nrobotPosition: x:%d y:%d z:%d", robotPosition.x, robotPosition.y, robotPosition.z);
+    }
+
+    // only use each frame once, or the same return would be counted every step until the next one
+    if(newFrame)
+    {
+        sense_obstacles(sensorValues);
+        if(pose_get().set)
+            map_ultrasonics(sensorValues);
+    }
+}
+
+void map_ultrasonics(struct AtmegaSensorValues sensorValues)
+{
+    const fix16_t angles[] = {
+        FIX16_FROM_FLOAT(ULTRASONIC_L_ANGLE * 3.14159265358979 / 180),
+        FIX16_FROM_FLOAT(ULTRASONIC_C_ANGLE * 3.14159265358979 / 180),
+        FIX16_FROM_FLOAT(ULTRASONIC_R_ANGLE * 3.14159265358979 / 180)
+    };
+    const long durations[] = {
+        sensorValues.Ultrasonic_L_Duration,
+        sensorValues.Ultrasonic_C_Duration,
+        sensorValues.Ultrasonic_R_Duration
+    };
+    struct Pose pose = pose_get();
+    // one time for the whole sweep, so the three returns count as a single fix of the robot
+    uint64_t now = time_us_64();
+
+    // the sensors are all at the front of the robot
+    long x = pose.x + FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(ULTRASONIC_MOUNT_OFFSET), fix16_cos(pose.heading)));
+    long y = pose.y + FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(ULTRASONIC_MOUNT_OFFSET), fix16_sin(pose.heading)));
+
+    int sensor;
+    for(sensor = Ultrasonic_L; sensor <= Ultrasonic_R; ++sensor)
+    {
+        if(durations[sensor] < 0)
+            continue;
+        fix16_t angle = pose.heading + angles[sensor];
+
+        // no echo means nothing within range, so it only clears
+        if(!Ultrasonic_HasEcho(durations[sensor]))
         {
-            // printf("\nfront obstacle");
-            action = MotionState_ToBeDetermined;
+            grid_update_ray(x, y, angle, GRID_MAX_RANGE);
+            continue;
         }
-        // obstacles all in front, but no rear, so backup
-        else if (obstacleCentre && obstacleRight && obstacleLeft && !obstacleRear)
+
+        long distance = Ultrasonic_CalculateDistance(durations[sensor]);
+        long pointX = x + FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(distance), fix16_cos(angle)));
+        long pointY = y + FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(distance), fix16_sin(angle)));
+
+        // something moving (someone walking past) is left off the map, or the planner would route around where they were
+        Movers_Motion motion = Movers_Motion_Still;
+        if(distance < GRID_MAX_RANGE)
+            motion = movers_add_return(pointX, pointY, pose.x, pose.y, now);
+        if(motion == Movers_Motion_Still)
+            grid_update_ray(x, y, angle, distance);
+
+        // close returns are also kept as points, so they're still avoided once the robot has turned and can't see them
+        if(distance + ULTRASONIC_MOUNT_OFFSET <= FOOTPRINT_REACH)
+            footprint_add_point(pointX, pointY, now);
+    }
+}
+
+void sense_obstacles(struct AtmegaSensorValues sensorValues)
+{
+    const fix16_t DEGREE = FIX16_FROM_FLOAT(3.14159265358979 / 180);
+    fix16_t heading = pose_get().heading;
+
+    vfh_fade();
+
+    track_ultrasonic(Ultrasonic_L, sensorValues.Ultrasonic_L_Duration);
+    track_ultrasonic(Ultrasonic_C, sensorValues.Ultrasonic_C_Duration);
+    track_ultrasonic(Ultrasonic_R, sensorValues.Ultrasonic_R_Duration);
+
+    // the histogram is fixed to the UWB axes, so turn each sensor's mounting angle into a direction from the heading
+    // (a sensor with no echo has nothing to add, it isn't something right in front of it)
+    if(Ultrasonic_HasEcho(sensorValues.Ultrasonic_L_Duration))
+        vfh_add_reading(heading + ULTRASONIC_L_ANGLE * DEGREE, ULTRASONIC_BEAM_ANGLE * DEGREE,
+            Ultrasonic_CalculateDistance(sensorValues.Ultrasonic_L_Duration) + ULTRASONIC_MOUNT_OFFSET);
+    if(Ultrasonic_HasEcho(sensorValues.Ultrasonic_C_Duration))
+        vfh_add_reading(heading + ULTRASONIC_C_ANGLE * DEGREE, ULTRASONIC_BEAM_ANGLE * DEGREE,
+            Ultrasonic_CalculateDistance(sensorValues.Ultrasonic_C_Duration) + ULTRASONIC_MOUNT_OFFSET);
+    if(Ultrasonic_HasEcho(sensorValues.Ultrasonic_R_Duration))
+        vfh_add_reading(heading + ULTRASONIC_R_ANGLE * DEGREE, ULTRASONIC_BEAM_ANGLE * DEGREE,
+            Ultrasonic_CalculateDistance(sensorValues.Ultrasonic_R_Duration) + ULTRASONIC_MOUNT_OFFSET);
+
+    // an edge in front of the robot, or something pressing on a bumper, is as close as it gets
+    if(IR_CheckForDrop(sensorValues.IR_L_Distance, 60))
+        vfh_add_reading(heading + IR_L_ANGLE * DEGREE, 0, 0);
+    if(IR_CheckForDrop(sensorValues.IR_R_Distance, 60))
+        vfh_add_reading(heading + IR_R_ANGLE * DEGREE, 0, 0);
+    if(sensorValues.Bump_L)
+        vfh_add_reading(heading + ATMEGA_BUMP_L_ANGLE * DEGREE, 0, 0);
+    if(sensorValues.Bump_R)
+        vfh_add_reading(heading + ATMEGA_BUMP_R_ANGLE * DEGREE, 0, 0);
+}
+
+void track_ultrasonic(Ultrasonic_Device device, long duration)
+{
+    if(Ultrasonic_HasEcho(duration))
+        Ultrasonic_UpdateTrack(&ultrasonicTracks[device], Ultrasonic_CalculateDistance(duration), time_us_64());
+    // no echo means nothing in range (not something at 0mm), so there's nothing to brake for
+    else if(duration >= 0)
+        ultrasonicTracks[device].set = 0;
+}
+
+fix16_t obstacle_speed(void)
+{
+    fix16_t speed = zone_speed();
+    int device;
+
+    for(device = Ultrasonic_L; device <= Ultrasonic_R; ++device)
+    {
+        struct Ultrasonic_Track * track = &ultrasonicTracks[device];
+        if(!track->set)
+            continue;
+
+        // the fastest the robot can go and still brake to a stop before the stopping distance (v^2 = 2ad)
+        long clearance = track->distance - STOP_DISTANCE;
+        if(clearance <= 0)
+            return 0;
+        if(clearance < 2000)
         {
-            // printf("\nfront/left/right obstacles only");
-            action = MotionState_Reverse;
+            fix16_t braking = fix16_sqrt(fix16_mul(2 * BRAKING, FIX16_FROM_INT(clearance) / 10));
+            if(braking < speed)
+                speed = braking;
         }
-        // obstacles everywhere, just stop
-        else
+
+        // and slower still the sooner it would reach it at the rate they are closing
+        fix16_t ttc = Ultrasonic_TimeToCollision(track);
+        if(ttc <= TTC_STOP)
+            return 0;
+        if(ttc < TTC_SLOW)
         {
-            // printf("\nall the obstacles");
-            action = MotionState_Stop;
-            //TODO: If we sit here too long, report a failed delivery
+            fix16_t closing = fix16_mul(SPEED, fix16_div(ttc - TTC_STOP, TTC_SLOW - TTC_STOP));
+            if(closing < speed)
+                speed = closing;
         }
-    }    
-    return action;
+    }
+
+    return speed;
 }
 
-void turn_right()
+fix16_t footprint_speed(fix16_t speed, fix16_t angular)
+{
+    struct Pose pose = pose_get();
+    long distance = footprint_free_distance(pose.x, pose.y, pose.heading, speed, angular, time_us_64());
+
+    if(distance >= FOOTPRINT_HORIZON)
+        return speed;
+
+    // the fastest the robot can go and still brake to a stop a step short of where it would touch (v^2 = 2ad)
+    long clearance = distance - FOOTPRINT_STEP;
+    if(clearance <= 0)
+        return 0;
+    return fix16_sqrt(fix16_mul(2 * BRAKING, FIX16_FROM_INT(clearance) / 10));
+}
+
+fix16_t drive_speed(struct VfhChoice choice, fix16_t error)
+{
+    // as fast as the way ahead is clear, and slow enough to stop before whatever the robot is closing on
+    fix16_t speed = fix16_mul(SPEED, choice.speed);
+    fix16_t limit = obstacle_speed();
+    if(limit < speed)
+        speed = limit;
+    // and before any part of the robot reaches something along the arc it's about to drive
+    limit = footprint_speed(speed, steer_rate(error));
+    if(limit < speed)
+        speed = limit;
+    return speed;
+}
+
+fix16_t zone_speed(void)
+{
+    struct Pose pose = pose_get();
+
+    if(!pose.set)
+        return SPEED;
+
+    long aheadX = pose.x + FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(ZONE_LOOKAHEAD), fix16_cos(pose.heading)));
+    long aheadY = pose.y + FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(ZONE_LOOKAHEAD), fix16_sin(pose.heading)));
+    fix16_t here = geofence_speed_limit(pose.x, pose.y);
+    fix16_t ahead = geofence_speed_limit(aheadX, aheadY);
+
+    // already in a keep out zone (the UWB can be 100mm out), so only let it drive if that's the way out
+    if(here == 0)
+        return fix16_mul(SPEED, ahead);
+
+    if(!geofence_segment_allowed(pose.x, pose.y, aheadX, aheadY))
+        return 0;
+    return fix16_mul(SPEED, here < ahead ? here : ahead);
+}
+
+fix16_t wheel_velocity(bool forward, char rpm)
+{
+    fix16_t velocity = fix16_div(FIX16_FROM_INT((uint8_t) rpm), MOTOR_RPM_PER_CMS);
+    return forward ? velocity : -velocity;
+}
+
+void raise_flag(void * flag)
+{
+    *(volatile bool *) flag = 1;
+}
+
+void request_user_location(void * data)
+{
+    ingest_request(Ingest_Command_GetUserLocation, 0);
+}
+
+int read_motor_rpm(Motor motor)
+{
+    struct AtmegaSensorValues sensorValues = ingest_get_sensor_values();
+    switch(motor)
+    {
+        case Motor_FL:
+            return sensorValues.Motor_FL_Speed;
+        case Motor_FR:
+            return sensorValues.Motor_FR_Speed;
+        case Motor_ML:
+            return sensorValues.Motor_ML_Speed;
+        case Motor_MR:
+            return sensorValues.Motor_MR_Speed;
+        case Motor_BL:
+            return sensorValues.Motor_BL_Speed;
+        case Motor_BR:
+            return sensorValues.Motor_BR_Speed;
+    }
+    return 0;
+}
+
+void run_background_tasks(void)
+{
+    scheduler_run(&scheduler);
+}
+
+void report_control_stats(void * data)
+{
+    struct ControlLoopStats stats = control_loop_get_stats();
+
+    printf("\ncontrol loop: %d steps, period %d us (min %d, avg %d, max %d), jitter %d us, latency %d us, step %d us, %d overruns",
+        stats.steps, stats.period_us, stats.period_min_us, stats.period_avg_us, stats.period_max_us,
+        stats.jitter_max_us, stats.latency_max_us, stats.step_max_us, stats.overruns);
+    scheduler_print_stats(&scheduler);
+
+    // start fresh so each report shows how the loop behaved since the last one
+    control_loop_reset_stats();
+}
+
+void idle_entry(void)
+{
+    stop();
+    planner_reset();
+    scheduleId = -1;
+    // check for changes to the zones before the next mission
+    ingest_request(Ingest_Command_GetZones, 0);
+    // and check for deliveries straight away (any still due after a tour will have been missed while it was out)
+    deliveryCheckDue = 1;
+}
+
+void idle_exit(void)
 {
-    if(currentRightMotorState != MotionState_TurnRight)
+    scheduler_cancel(&scheduler, deliveryCheckTask);
+    deliveryCheckDue = 0;
+}
+
+void idle_during(void)
+{
+    static struct GeofenceZones zones;
+
+    // new zones from the server take effect (and are kept) straight away, the robot isn't going anywhere
+    if(ingest_take_zones(&zones) && memcmp(&zones, geofence_get(), sizeof(zones)) != 0)
     {
-        printf("\ngo backward right");
-        motor_reverse(Motor_FR, SPEED);
-        currentRightMotorState = MotionState_TurnRight;
+        geofence_load(&zones);
+        (void) store_save(Store_Record_Geofence, GEOFENCE_VERSION, geofence_get(), sizeof(struct GeofenceZones));
+        printf("\n%d zones loaded from the server", geofence_get()->count);
     }
-    if(currentLeftMotorState != MotionState_TurnRight)
+
+    if(idle())
     {
-        printf("\ngo forward left");
-        motor_forward(Motor_FL, SPEED); 
-        currentLeftMotorState = MotionState_TurnRight;
+        // visit the deliveries in the shortest order, starting and finishing at home
+        long length = tour_plan(&tour, 0, 0, planner_estimate);
+        printf("\n%d deliveries due, %ld mm tour", tour.count, length);
+        hsm_dispatch(&robot, RobotEvent_ScheduleDue);
     }
 }
 
-void turn_left()
+void mission_entry(void)
+{
+    // start following the user afresh (they'll have moved since the last delivery)
+    track_reset(&userTrack);
+    userPosition.set = 0;
+}
+
+void navigating_to_user_entry(void)
+{
+    struct TourStop stop;
+
+    navigating_home_entry();
+
+    // head for where the user was when the deliveries were fetched, until there's something newer
+    if(tour_current(&tour, &stop))
+    {
+        scheduleId = stop.scheduleId;
+        if(!userPosition.set)
+        {
+            userPosition.x = stop.x;
+            userPosition.y = stop.y;
+            userPosition.z = 0;
+            userPosition.set = 1;
+        }
+    }
+
+    // the server can only say where the user is now when there's just the one delivery
+    if(tour.count == 1)
+        userRequestTask = scheduler_add(&scheduler, "user location", time_us_64(), USER_REQUEST_DURATION, request_user_location, NULL);
+}
+
+void navigating_to_user_exit(void)
+{
+    // only keep asking where the user is while heading for them
+    scheduler_cancel(&scheduler, userRequestTask);
+}
+
+void navigating_to_user_during(void)
+{
+    navigation_result(navigating_to_user(sensorValues));
+}
+
+void navigating_home_entry(void)
+{
+    // plan from wherever the robot is now, and time being stopped from scratch
+    planner_reset();
+    scheduler_cancel(&scheduler, stuckTimer);
+    stuckDetected = 0;
+    scheduler_cancel(&scheduler, yieldTimer);
+    yieldExpired = 0;
+}
+
+void navigating_home_during(void)
+{
+    navigation_result(navigating_home(sensorValues));
+}
+
+void docking_entry(void)
+{
+    dock_start(0, 0, HOME_HEADING, pose_get());
+    dockRangeTime = 0;
+}
+
+void docking_during(void)
 {
-    if(currentRightMotorState != MotionState_TurnLeft)
+    struct Ultrasonic_Track * centre = &ultrasonicTracks[Ultrasonic_C];
+    long range = -1;
+
+    // only a range that's new counts, so the same reading isn't taken into the estimate over and over
+    if(centre->set && centre->time != dockRangeTime)
     {
-        printf("\ngo forward right");
-        motor_forward(Motor_FR, SPEED);
-        currentRightMotorState = MotionState_TurnLeft;
+        dockRangeTime = centre->time;
+        range = centre->distance + ULTRASONIC_MOUNT_OFFSET;
     }
-    if(currentLeftMotorState != MotionState_TurnLeft)
+
+    // the dock face is meant to be ahead, so nothing slows it down for that, but an edge or a bump still stops it there
+    bool blocked = IR_CheckForDrop(sensorValues.IR_L_Distance, 60) || IR_CheckForDrop(sensorValues.IR_R_Distance, 60) ||
+                   sensorValues.Bump_L || sensorValues.Bump_R;
+    struct DockCommand command = dock_step(pose_get(), range, FIX16_ONE / CONTROL_RATE_HZ);
+
+    if(command.done || blocked)
+    {
+        long along, across;
+        dock_get_error(&along, &across);
+        printf("\ndocked %d mm short, %d mm to the side", along, across);
+        stop();
+        hsm_dispatch(&robot, RobotEvent_Arrived);
+    }
+    else
     {
-        printf("\ngo backward left");
-        motor_reverse(Motor_FL, SPEED); 
-        currentLeftMotorState = MotionState_TurnLeft;
+        arc(command.linear, command.angular);
     }
 }
 
-void go_forward()
+void navigation_result(NavigationResult result)
+{
+    if(result == NavigationResult_Complete)
+        hsm_dispatch(&robot, RobotEvent_Arrived);
+    else if(result == NavigationResult_Stuck)
+        hsm_dispatch(&robot, RobotEvent_Stuck);
+}
+
+void delivering_entry(void)
+{
+    stop();
+}
+
+void await_load(void)
+{
+    RobotState state = hsm_current(&robot);
+    // waiting for the dose to be taken off, then for the cup to be put back
+    Weight_LoadState awaitedState = state == RobotState_WaitingRemoval ? Weight_LoadNotPresent : Weight_LoadPresent;
+
+    // it has to stay that way for the state's whole timeout before it counts, so start the timing again whenever it isn't
+    if(Weight_CheckForLoad(sensorValues.Weight) != awaitedState)
+        hsm_reset_timer(&robot, state);
+}
+
+void log_delivery(void)
+{
+    printf("\ndose taken");
+    ingest_request(Ingest_Command_LogDelivery, scheduleId);
+}
+
+void next_stop_during(void)
+{
+    // the next user is somewhere else, so stop following the last one
+    track_reset(&userTrack);
+    userPosition.set = 0;
+
+    if(tour_advance(&tour))
+        hsm_dispatch(&robot, RobotEvent_NextStop);
+    else
+        hsm_dispatch(&robot, RobotEvent_TourDone);
+}
+
+void stuck_entry(void)
+{
+    struct Pose pose = pose_get();
+
+    motion_cancel();
+    stop();
+    recovery.stuckX = pose.x;
+    recovery.stuckY = pose.y;
+
+    // what led up to it, from the state machine's log
+    printf("\nstuck, after:");
+    hsm_print_log(&robot, 16);
+}
+
+void back_off_entry(void)
+{
+    motion_start_drive(Motor_Reverse, RECOVERY_SPEED, RECOVERY_BACK_OFF_MS);
+    // (the primitive drives the motors itself, so make sure the next instruction is always sent)
+    currentMotionState = MotionState_ToBeDetermined;
+    recovery.settled = 0;
+}
+
+void back_off_during(void)
+{
+    // the bumpers are at the back, so they're what it would reverse into
+    if(sensorValues.Bump_L || sensorValues.Bump_R)
+        motion_cancel();
+
+    if(!recovery_settled())
+        return;
+
+    if(recovery_way_clear())
+        hsm_dispatch(&robot, RobotEvent_Freed);
+    else
+        hsm_dispatch(&robot, RobotEvent_Failed);
+}
+
+void probe_entry(void)
+{
+    // turn towards whichever side has more room
+    long left = ultrasonicTracks[Ultrasonic_L].set ? ultrasonicTracks[Ultrasonic_L].distance : 0;
+    long right = ultrasonicTracks[Ultrasonic_R].set ? ultrasonicTracks[Ultrasonic_R].distance : 0;
+
+    recovery.turnDirection = left >= right ? Motion_Turn_Left : Motion_Turn_Right;
+    recovery.turns = 0;
+    recovery.settled = 1;
+}
+
+void probe_during(void)
 {
-    if(currentRightMotorState != MotionState_Forward)
+    if(!recovery_settled())
+        return;
+
+    if(recovery_way_clear())
     {
-        printf("\ngo forward right");
-        motor_forward(Motor_FR, SPEED);
-        currentRightMotorState = MotionState_Forward;
+        hsm_dispatch(&robot, RobotEvent_Freed);
     }
-    if(currentLeftMotorState != MotionState_Forward)
+    else if(recovery.turns >= RECOVERY_PROBE_TURNS)
+    {
+        hsm_dispatch(&robot, RobotEvent_Failed);
+    }
+    else
     {
-        printf("\ngo forward left");
-        motor_forward(Motor_FL, SPEED); 
-        currentLeftMotorState = MotionState_Forward;
+        motion_start_turn(recovery.turnDirection, RECOVERY_TURN_SPEED, RECOVERY_PROBE_TURN_MS);
+        currentMotionState = MotionState_ToBeDetermined;
+        recovery.settled = 0;
+        ++recovery.turns;
     }
 }
 
-void go_backward()
+void follow_wall_entry(void)
+{
+    // follow whichever wall is closest
+    long left = ultrasonicTracks[Ultrasonic_L].set ? ultrasonicTracks[Ultrasonic_L].distance : LONG_MAX;
+    long right = ultrasonicTracks[Ultrasonic_R].set ? ultrasonicTracks[Ultrasonic_R].distance : LONG_MAX;
+
+    recovery.wallSide = left <= right ? Ultrasonic_L : Ultrasonic_R;
+}
+
+void follow_wall_during(void)
 {
-    if(currentRightMotorState != MotionState_Reverse)
+    struct Pose pose = pose_get();
+    long xDiff = pose.x - recovery.stuckX;
+    long yDiff = pose.y - recovery.stuckY;
+
+    // far enough along the wall to have got round whatever was in the way
+    if(xDiff * xDiff + yDiff * yDiff >= RECOVERY_ESCAPE_DISTANCE * RECOVERY_ESCAPE_DISTANCE && recovery_way_clear())
     {
-        printf("\ngo backward right");
-        motor_reverse(Motor_FR, SPEED);
-        currentRightMotorState = MotionState_Reverse;
+        hsm_dispatch(&robot, RobotEvent_Freed);
+        return;
     }
-    if(currentLeftMotorState != MotionState_Reverse)
+
+    bool dropImminent = IR_CheckForDrop(sensorValues.IR_L_Distance, 60) || IR_CheckForDrop(sensorValues.IR_R_Distance, 60);
+    fix16_t speed = obstacle_speed();
+    if(speed > RECOVERY_SPEED)
+        speed = RECOVERY_SPEED;
+
+    if(dropImminent || speed == 0)
     {
-        printf("\ngo backward left");
-        motor_reverse(Motor_FL, SPEED); 
-        currentLeftMotorState = MotionState_Reverse;
+        // the way ahead is blocked, turn away from the wall until it isn't
+        if(recovery.wallSide == Ultrasonic_L)
+            turn_right();
+        else
+            turn_left();
+        return;
     }
+
+    // steer towards the wall when too far from it (or it's been lost), and away when too close
+    struct Ultrasonic_Track * wall = &ultrasonicTracks[recovery.wallSide];
+    long distance = wall->set ? wall->distance : 2 * RECOVERY_WALL_DISTANCE;
+    fix16_t angular = fix16_mul(FIX16_FROM_INT(distance - RECOVERY_WALL_DISTANCE) / 1000, RECOVERY_WALL_GAIN);
+    if(angular > ARC_RATE)
+        angular = ARC_RATE;
+    else if(angular < -ARC_RATE)
+        angular = -ARC_RATE;
+
+    arc(speed, recovery.wallSide == Ultrasonic_L ? angular : -angular);
 }
 
-void stop()
+void report_entry(void)
+{
+    stop();
+    printf("\nstuck, asking for help");
+    ingest_request(Ingest_Command_ReportStuck, scheduleId);
+}
+
+void report_during(void)
+{
+    // someone may come and move whatever is in the way
+    if(recovery_way_clear())
+        hsm_dispatch(&robot, RobotEvent_Freed);
+}
+
+bool recovery_settled(void)
+{
+    if(!motion_is_done())
+        return 0;
+
+    if(!recovery.settled)
+    {
+        recovery.settled = 1;
+        motion_start_stop_settle(RECOVERY_SETTLE_MS);
+        return 0;
+    }
+    return 1;
+}
+
+bool recovery_way_clear(void)
+{
+    // the same test navigate uses to decide it's stuck, towards the waypoint it was heading for
+    bool dropImminent = IR_CheckForDrop(sensorValues.IR_L_Distance, 60) || IR_CheckForDrop(sensorValues.IR_R_Distance, 60);
+    struct Pose pose = pose_get();
+    struct VfhChoice choice = vfh_choose(fix16_atan2(navigationTarget.y - pose.y, navigationTarget.x - pose.x));
+    fix16_t error = fix16_wrap_angle(choice.heading - pose.heading);
+
+    return !way_blocked(choice, error, drive_speed(choice, error), dropImminent);
+}
+
+bool way_blocked(struct VfhChoice choice, fix16_t error, fix16_t speed, bool dropImminent)
 {
-    if(currentRightMotorState != MotionState_Stop)
+    // boxed in, or the only way out would mean driving forward (over an edge or into something)
+    return !choice.clear || ((dropImminent || speed == 0) && error <= STEER_SPIN_ANGLE && error >= -STEER_SPIN_ANGLE);
+}
+
+void record_tare(void)
+{
+    // the dose has just been taken off, so this is what the sensor reads empty
+    int reading = sensorValues.Weight;
+
+    if(abs(reading - Weight_GetTare()) > WEIGHT_TARE_TOLERANCE)
     {
-        printf("\nstop right");
-        motor_stop(Motor_FR);
-        currentRightMotorState = MotionState_Stop;
+        Weight_SetTare(reading);
+        (void) store_save(Store_Record_WeightTare, TARE_RECORD_VERSION, &reading, sizeof(reading));
     }
-    if(currentLeftMotorState != MotionState_Stop)
+}
+
+void save_home(void)
+{
+    static uint8_t map[GRID_SERIALISED_MAX];
+    fix16_t heading = pose_get().heading;
+    size_t length = grid_serialise(map, sizeof(map));
+
+    // the robot is stopped at home, so it's a good time for the flash to be busy
+    (void) store_save(Store_Record_Home, HOME_RECORD_VERSION, &heading, sizeof(heading));
+    if(length > 0)
+        (void) store_save(Store_Record_Map, GRID_SERIALISED_VERSION, map, length);
+    if(routesChanged)
+        routesChanged = !store_save(Store_Record_Routes, ROUTES_VERSION, routes_get(), sizeof(struct Routes));
+}
+
+void load_stored(void)
+{
+    uint64_t start = time_us_64();
+    fix16_t heading = HOME_HEADING;
+    int tare;
+    size_t length;
+
+    // pick up where the last run left off: the map, the zones, the routes driven, which way the robot was parked and the weight sensor's tare
+    const uint8_t * map = store_find(Store_Record_Map, GRID_SERIALISED_VERSION, &length);
+    bool mapLoaded = map != NULL && grid_deserialise(map, length);
+    if(!mapLoaded)
+        grid_clear();
+
+    static struct GeofenceZones zones;
+    if(store_load(Store_Record_Geofence, GEOFENCE_VERSION, &zones, sizeof(zones)))
+        geofence_load(&zones);
+    else
+        geofence_clear();
+
+    static struct Routes routes;
+    if(!store_load(Store_Record_Routes, ROUTES_VERSION, &routes, sizeof(routes)) || !routes_load(&routes))
+        routes_clear();
+
+    (void) store_load(Store_Record_Home, HOME_RECORD_VERSION, &heading, sizeof(heading));
+    pose_init(heading);
+
+    if(store_load(Store_Record_WeightTare, TARE_RECORD_VERSION, &tare, sizeof(tare)))
+        Weight_SetTare(tare);
+
+    printf("\nloaded stored records in %d us (map %s)", (int) (time_us_64() - start), mapLoaded ? "loaded" : "empty");
+}
+
+void check_boot(void * data)
+{
+    static struct IngestStatus reported = {0, 0, 0};
+    struct IngestStatus status = ingest_get_status();
+    uint64_t now = time_us_64();
+
+    // report each of core 1's subsystems as it comes up (the wifi can take a while, or never come)
+    if(status.sensors_us && !reported.sensors_us)
+        printf("\nboot: sensors ready at %d ms", (int) (status.sensors_us / 1000));
+    if(status.uwb_us && !reported.uwb_us)
+        printf("\nboot: uwb ready at %d ms", (int) (status.uwb_us / 1000));
+    if(status.wifi_us && !reported.wifi_us)
+        printf("\nboot: wifi ready at %d ms", (int) (status.wifi_us / 1000));
+    reported = status;
+
+    if((status.sensors_us && status.uwb_us && status.wifi_us) || now >= BOOT_REPORT_TIMEOUT)
     {
-        printf("\nstop left");
-        motor_stop(Motor_FL); 
-        currentLeftMotorState = MotionState_Stop;
+        // (the stdio connection is likely up by now, so the whole breakdown is printed in one go)
+        printf("\nboot breakdown (ms since power on, and how long each took once it could start):");
+        print_ready("store", storeReady, 0);
+        print_ready("motors", motorsReady, storeReady);
+        print_ready("map", mapReady, ingestLaunched);
+        // core 1 brings these up alongside each other
+        print_ready("sensors", status.sensors_us, ingestLaunched);
+        print_ready("uwb", status.uwb_us, ingestLaunched);
+        print_ready("wifi", status.wifi_us, ingestLaunched);
+        scheduler_cancel(&scheduler, bootTask);
     }
 }
 
-bool has_duration_passed(uint64_t snapshot, uint64_t duration)
+void print_ready(const char * name, uint64_t ready, uint64_t previous)
 {
-    uint64_t difference = (time_us_64() - snapshot) / 1000; // divided by 1000 to convert to ms
-    return difference >= duration;
+    if(ready == 0)
+        printf("\n  %-8s not ready", name);
+    else
+        printf("\n  %-8s %6d ms (+%d ms)", name, (int) (ready / 1000), (int) ((ready - previous) / 1000));
 }
\ No newline at end of file
@@ -6,7 +6,6 @@
  */
  
 #include <stdio.h>
-#include <math.h>
 #include <string.h>
 #include <ctype.h>
 #include "pico/stdlib.h"
@@ -54,6 +53,8 @@ void atmega_parse_bytes(void);
 
 volatile struct AtmegaFrame frames[ATMEGA_MAX_FRAMES_STORED];
 volatile int current_frame_index = 0;
+// total number of complete frames received, so readers can tell when there's a new one
+volatile uint32_t frames_received = 0;
 
 /************************************************************************/
 /* Header Implementation                                                */
@@ -105,8 +106,13 @@ void atmega_receive_data(void)
             frame_begin = 1;
         }
         // end frame seen after a start frame is seen and we got the expected number of bytes
-        else if(ch == ATMEGA_END_BYTE && frame_begin && bytesReceived == ATMEGA_FRAME_LENGTH)
+        // (the two motor chassis sends a shorter frame without the middle/back motor speeds, and older firmware shorter still)
+        else if(ch == ATMEGA_END_BYTE && frame_begin && 
+                (bytesReceived == ATMEGA_FRAME_LENGTH || bytesReceived == ATMEGA_FRONT_FRAME_LENGTH ||
+                 bytesReceived == ATMEGA_LEGACY_FRAME_LENGTH))
         {
+            // terminate the buffer so a shorter frame doesn't pick up the tail of a longer one
+            rxBuff[bytesReceived] = 0;
             // move storage of frames to the next slot available
             ++current_frame_index;
             // roll over if we reached the end of the total amount of frames allowed (overwrite oldest frame)
@@ -144,6 +150,11 @@ struct AtmegaSensorValues atmega_retrieve_sensor_values(void)
     return atmega_parse_frame(atmega_retrieve_frame());
 }
 
+uint32_t atmega_frames_received(void)
+{
+    return frames_received;
+}
+
 struct AtmegaFrame atmega_retrieve_frame(void)
 {
     return frames[current_frame_index];
@@ -172,6 +183,10 @@ void atmega_parse_bytes(void)
     strcpy(frame.Motor_Directions, "00");
     strcpy(frame.Motor_Speed_FL, "00");
     strcpy(frame.Motor_Speed_FR, "00");
+    strcpy(frame.Motor_Speed_ML, "00");
+    strcpy(frame.Motor_Speed_MR, "00");
+    strcpy(frame.Motor_Speed_BL, "00");
+    strcpy(frame.Motor_Speed_BR, "00");
     strcpy(frame.Ultrasonic_L, "00000");
     strcpy(frame.Ultrasonic_C, "00000");
     strcpy(frame.Ultrasonic_R, "00000");
@@ -185,6 +200,7 @@ void atmega_parse_bytes(void)
     }
     
     frames[current_frame_index] = frame;
+    ++frames_received;
 }
 
 struct AtmegaSensorValues atmega_parse_frame(struct AtmegaFrame frame)
@@ -223,17 +239,17 @@ struct AtmegaSensorValues atmega_parse_frame(struct AtmegaFrame frame)
     // check the appropriate bits from the m_directions value for 0/1
     sv.Motor_FL_Direction = m_directions & ATMEGA_MOTOR_FL_Direction;
     sv.Motor_FR_Direction = m_directions & ATMEGA_MOTOR_FR_Direction;
-    // sv.Motor_ML_Direction = m_directions & ATMEGA_MOTOR_ML_Direction;
-    // sv.Motor_MR_Direction = m_directions & ATMEGA_MOTOR_MR_Direction;
-    // sv.Motor_BL_Direction = m_directions & ATMEGA_MOTOR_BL_Direction;
-    // sv.Motor_BR_Direction = m_directions & ATMEGA_MOTOR_BR_Direction;
+    sv.Motor_ML_Direction = m_directions & ATMEGA_MOTOR_ML_Direction;
+    sv.Motor_MR_Direction = m_directions & ATMEGA_MOTOR_MR_Direction;
+    sv.Motor_BL_Direction = m_directions & ATMEGA_MOTOR_BL_Direction;
+    sv.Motor_BR_Direction = m_directions & ATMEGA_MOTOR_BR_Direction;
 
     sv.Motor_FL_Speed = convert_bytes_string_to_hex(frame.Motor_Speed_FL, 1);
     sv.Motor_FR_Speed = convert_bytes_string_to_hex(frame.Motor_Speed_FR, 1);
-    // sv.Motor_ML_Speed = convert_bytes_string_to_hex(&frame.Motor_Speed_ML, 1);
-    // sv.Motor_MR_Speed = convert_bytes_string_to_hex(&frame.Motor_Speed_MR, 1);
-    // sv.Motor_BL_Speed = convert_bytes_string_to_hex(&frame.Motor_Speed_BL, 1);
-    // sv.Motor_BR_Speed = convert_bytes_string_to_hex(&frame.Motor_Speed_BR, 1);
+    sv.Motor_ML_Speed = convert_bytes_string_to_hex(frame.Motor_Speed_ML, 1);
+    sv.Motor_MR_Speed = convert_bytes_string_to_hex(frame.Motor_Speed_MR, 1);
+    sv.Motor_BL_Speed = convert_bytes_string_to_hex(frame.Motor_Speed_BL, 1);
+    sv.Motor_BR_Speed = convert_bytes_string_to_hex(frame.Motor_Speed_BR, 1);
 
     // check to see if the converted value is 0 or 1
     sv.Battery_Low = convert_string_to_hex(frame.Battery) & 1;
@@ -307,25 +323,22 @@ struct AtmegaFrame atmega_read_byte_into_frame(struct AtmegaFrame frame, char by
         frame.Motor_Speed_FR[0] = c;
     if(byteCount == 31)
         frame.Motor_Speed_FR[1] = c;
-    // } else if (byteCount < 30) {
-    //     *frame.Motor_Speed_FL = c;
-    //     ++*frame.Motor_Speed_FL;
-    // } else if (byteCount < 32) {
-    //     *frame.Motor_Speed_FR = c;
-    //     ++*frame.Motor_Speed_FR;
-    // } else if (byteCount < 34) {
-    //     *frame.Motor_Speed_ML = c;
-    //    ++*frame.Motor_Speed_ML;
-    // } else if (byteCount < 36) {
-    //     *frame.Motor_Speed_MR = c;
-    //    ++*frame.Motor_Speed_MR;
-    // } else if (byteCount < 38) {
-    //     *frame.Motor_Speed_BL = c;
-    //    ++*frame.Motor_Speed_BL;
-    // } else if (byteCount < 40) {
-    //     *frame.Motor_Speed_BR = c;
-    //    ++*frame.Motor_Speed_BR;
-    //}
+    if(byteCount == 32)
+        frame.Motor_Speed_ML[0] = c;
+    if(byteCount == 33)
+        frame.Motor_Speed_ML[1] = c;
+    if(byteCount == 34)
+        frame.Motor_Speed_MR[0] = c;
+    if(byteCount == 35)
+        frame.Motor_Speed_MR[1] = c;
+    if(byteCount == 36)
+        frame.Motor_Speed_BL[0] = c;
+    if(byteCount == 37)
+        frame.Motor_Speed_BL[1] = c;
+    if(byteCount == 38)
+        frame.Motor_Speed_BR[0] = c;
+    if(byteCount == 39)
+        frame.Motor_Speed_BR[1] = c;
 
     return frame;
 }
@@ -338,9 +351,9 @@ long convert_bytes_string_to_hex(char * bytes, char startByteIndex)
     while(byteIndex >= 0)
     {
         char c = convert_string_to_hex(*bytes);
-        // starting from the MSB, add the current byte value to the return value
-        // with the approrpiate position in significance
-        value += c * pow(16, byteIndex);
+        // starting from the MSB, shift the value up a hex digit and add the current byte value
+        // (same as multiplying by the appropriate power of 16, without the software floating point)
+        value = (value << 4) + c;
         // move to the next byte
         ++bytes;
 
@@ -86,22 +86,30 @@
     Speed of Front Right Motor (from encoders)
     Measured in RPMs, max possible value is 255, though it should never be above 170
 
-    Segment 13: (2 byte) -- not in use
+    Segment 13: (2 byte) -- only sent by the six motor chassis
     Speed of Middle Left Motor (from encoders)
     Measured in RPMs, max possible value is 255, though it should never be above 170
 
-    Segment 14: (2 byte) -- not in use
+    Segment 14: (2 byte) -- only sent by the six motor chassis
     Speed of Middle Right Motor (from encoders)
     Measured in RPMs, max possible value is 255, though it should never be above 170
 
-    Segment 15: (2 byte) -- not in use
+    Segment 15: (2 byte) -- only sent by the six motor chassis
     Speed of Back Left Motor (from encoders)
     Measured in RPMs, max possible value is 255, though it should never be above 170
 
-    Segment 16: (2 byte) -- not in use
-    Speed of Back Left Motor (from encoders)
+    Segment 16: (2 byte) -- only sent by the six motor chassis
+    Speed of Back Right Motor (from encoders)
     Measured in RPMs, max possible value is 255, though it should never be above 170
+
+    Frames from the two motor chassis stop after segment 12 (ATMEGA_FRONT_FRAME_LENGTH), 
+    the speeds of the missing motors are reported as 0
+    Firmware that hasn't been updated for the six motor chassis sends one byte less than that 
+    (ATMEGA_LEGACY_FRAME_LENGTH, without the last digit of segment 12), which is still accepted 
+    and parsed as it always was (the missing digit reads as 0)
 */
+#ifndef ATMEGAH
+#define ATMEGAH
 
 // We are using pins 0 and 1, but see the GPIO function select table in the
 // datasheet for information on which other pins can be used.
@@ -115,7 +123,9 @@
 #define ATMEGA_PARITY    UART_PARITY_NONE
 
 #define ATMEGA_MAX_FRAMES_STORED 5   // max number of frames that can be stored before we start overwriting the oldest ones
-#define ATMEGA_FRAME_LENGTH      31  // not inclusive of start/end bytes
+#define ATMEGA_FRAME_LENGTH        40  // not inclusive of start/end bytes
+#define ATMEGA_FRONT_FRAME_LENGTH  32  // frame length when only the front motor speeds are sent (segments 1-12)
+#define ATMEGA_LEGACY_FRAME_LENGTH 31  // frame length from firmware older than the six motor chassis
 #define ATMEGA_START_BYTE        '$' // indicator of a start frame
 #define ATMEGA_END_BYTE          '^' // indicator of an end frame
 
@@ -133,12 +143,16 @@
 #define ATMEGA_BUMP_L 0b10
 #define ATMEGA_BUMP_R 0b01
 
+// Where the bump sensors are, in degrees counter-clockwise from straight ahead (both are at the back corners)
+#define ATMEGA_BUMP_L_ANGLE 150
+#define ATMEGA_BUMP_R_ANGLE -150
+
 #define ATMEGA_MOTOR_FL_Direction 0b00100000
 #define ATMEGA_MOTOR_FR_Direction 0b00010000
-// #define ATMEGA_MOTOR_ML_Direction 0b00001000
-// #define ATMEGA_MOTOR_MR_Direction 0b00000100
-// #define ATMEGA_MOTOR_BL_Direction 0b00000010
-// #define ATMEGA_MOTOR_BR_Direction 0b00000001
+#define ATMEGA_MOTOR_ML_Direction 0b00001000
+#define ATMEGA_MOTOR_MR_Direction 0b00000100
+#define ATMEGA_MOTOR_BL_Direction 0b00000010
+#define ATMEGA_MOTOR_BR_Direction 0b00000001
 
 struct AtmegaFrame {
     char Changed[3];
@@ -153,10 +167,10 @@ struct AtmegaFrame {
     char Motor_Directions[3];
     char Motor_Speed_FL[3];
     char Motor_Speed_FR[3];
-    // char Motor_Speed_ML[3];
-    // char Motor_Speed_MR[3];
-    // char Motor_Speed_BL[3];
-    // char Motor_Speed_BR[3];
+    char Motor_Speed_ML[3];
+    char Motor_Speed_MR[3];
+    char Motor_Speed_BL[3];
+    char Motor_Speed_BR[3];
 };
 
 struct AtmegaSensorValues {
@@ -191,17 +205,17 @@ struct AtmegaSensorValues {
     bool Motor_FR_Direction;    // 1 if forward
     char Motor_FR_Speed;        // measured in RPM
 
-    // bool Motor_ML_Direction;    // 1 if forward
-    // char Motor_ML_Speed;        // measured in RPM
+    bool Motor_ML_Direction;    // 1 if forward
+    char Motor_ML_Speed;        // measured in RPM
 
-    // bool Motor_MR_Direction;    // 1 if forward
-    // char Motor_MR_Speed;        // measured in RPM
+    bool Motor_MR_Direction;    // 1 if forward
+    char Motor_MR_Speed;        // measured in RPM
 
-    // bool Motor_BL_Direction;    // 1 if forward
-    // char Motor_BL_Speed;        // measured in RPM
+    bool Motor_BL_Direction;    // 1 if forward
+    char Motor_BL_Speed;        // measured in RPM
 
-    // bool Motor_BR_Direction;    // 1 if forward
-    // char Motor_BR_Speed;        // measured in RPM
+    bool Motor_BR_Direction;    // 1 if forward
+    char Motor_BR_Speed;        // measured in RPM
 };
 
 // initialize the atmega to run on UART0
@@ -210,6 +224,9 @@ void atmega_init_communication(void);
 void atmega_receive_data(void);
 // returns the current sensor values stored
 struct AtmegaSensorValues atmega_retrieve_sensor_values(void);
+// returns the number of complete frames received so far (changes whenever there are new sensor values)
+uint32_t atmega_frames_received(void);
 // Send a request to the atmega via uart. Not currently used
 void atmega_send_data(char * data);
 
+#endif
\ No newline at end of file
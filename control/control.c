@@ -0,0 +1,144 @@
+/*
+ * control.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "control.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+/// @brief Timer callback marking the next control step as due
+/// @param timer The repeating timer that fired
+/// @return true to keep the timer repeating
+bool control_tick(repeating_timer_t *timer);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+// Timer firing once per control period
+repeating_timer_t control_timer;
+
+// Set by the timer when a step is due, cleared when the main loop picks it up
+volatile bool step_pending = 0;
+// When the pending step came due
+volatile uint64_t tick_time = 0;
+
+// When the last step started (0 if no step has run since the stats were reset)
+uint64_t last_step_start = 0;
+// Running total of the periods, used for the average
+uint64_t period_total = 0;
+
+volatile struct ControlLoopStats stats;
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+bool control_loop_init(uint32_t rate_hz)
+{
+    stats.period_us = 1000000 / rate_hz;
+    control_loop_reset_stats();
+    // a negative delay keeps the ticks a fixed period apart, regardless of how long the callback takes
+    return add_repeating_timer_us(-(int64_t) stats.period_us, control_tick, NULL, &control_timer);
+}
+
+bool control_loop_ready(void)
+{
+    bool ready;
+    uint32_t interrupts = save_and_disable_interrupts();
+    ready = step_pending;
+    step_pending = 0;
+    restore_interrupts(interrupts);
+    return ready;
+}
+
+void control_loop_wait(void)
+{
+    // the tick sets the event flag, so one that came in after control_loop_ready isn't slept through
+    __wfe();
+}
+
+void control_loop_step_begin(void)
+{
+    uint64_t now = time_us_64();
+    uint32_t latency = now - tick_time;
+
+    if(latency > stats.latency_max_us)
+        stats.latency_max_us = latency;
+
+    if(last_step_start)
+    {
+        uint32_t period = now - last_step_start;
+        uint32_t jitter = period > stats.period_us ? period - stats.period_us : stats.period_us - period;
+
+        if(period < stats.period_min_us)
+            stats.period_min_us = period;
+        if(period > stats.period_max_us)
+            stats.period_max_us = period;
+        if(jitter > stats.jitter_max_us)
+            stats.jitter_max_us = jitter;
+
+        period_total += period;
+        // the first step after a reset has no period, so there is one less period than steps
+        stats.period_avg_us = period_total / stats.steps;
+    }
+
+    last_step_start = now;
+    ++stats.steps;
+}
+
+void control_loop_step_end(void)
+{
+    uint32_t duration = time_us_64() - last_step_start;
+    if(duration > stats.step_max_us)
+        stats.step_max_us = duration;
+}
+
+struct ControlLoopStats control_loop_get_stats(void)
+{
+    struct ControlLoopStats snapshot;
+    // overruns are counted by the timer, so take the copy without it firing part way through
+    uint32_t interrupts = save_and_disable_interrupts();
+    snapshot = stats;
+    restore_interrupts(interrupts);
+    return snapshot;
+}
+
+void control_loop_reset_stats(void)
+{
+    uint32_t interrupts = save_and_disable_interrupts();
+    stats.steps = 0;
+    stats.overruns = 0;
+    stats.period_min_us = UINT32_MAX;
+    stats.period_max_us = 0;
+    stats.period_avg_us = 0;
+    stats.jitter_max_us = 0;
+    stats.latency_max_us = 0;
+    stats.step_max_us = 0;
+    last_step_start = 0;
+    period_total = 0;
+    restore_interrupts(interrupts);
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+bool control_tick(repeating_timer_t *timer)
+{
+    // the last tick still hasn't been run, so the loop has fallen behind by a whole period
+    if(step_pending)
+        ++stats.overruns;
+
+    step_pending = 1;
+    tick_time = time_us_64();
+    // wake the main loop if it's waiting for the tick
+    __sev();
+    return true;
+}
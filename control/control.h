@@ -0,0 +1,46 @@
+/*
+ * control.h
+ * Fixed rate timing for the control loop
+ * A repeating timer marks when each control step is due, the main loop runs the step when it sees the tick
+ * and does background work in between. Keeps track of how regular the steps actually were
+ *
+ * Created: 2026-10-19
+ */
+#ifndef CONTROLH
+#define CONTROLH
+
+#include "pico/stdlib.h"
+
+struct ControlLoopStats {
+    uint32_t period_us;         // nominal time between steps
+    uint32_t steps;             // number of steps run since the stats were reset
+    uint32_t overruns;          // ticks that came due before the previous one had been run (a step was skipped)
+    uint32_t period_min_us;     // shortest measured time between the start of two steps
+    uint32_t period_max_us;     // longest measured time between the start of two steps
+    uint32_t period_avg_us;     // average measured time between the start of two steps
+    uint32_t jitter_max_us;     // largest difference between a measured period and the nominal period
+    uint32_t latency_max_us;    // longest time between a tick coming due and its step starting
+    uint32_t step_max_us;       // longest time a single step took to run
+};
+
+// Start the timer that marks the control steps as due at the rate (in Hz)
+bool control_loop_init(uint32_t rate_hz);
+
+// Check if a control step is due, clearing it so it is only seen once
+bool control_loop_ready(void);
+
+// Sleep until something wakes the core (the next tick at the latest), returns straight away if a tick has come since
+// control_loop_ready was last checked
+void control_loop_wait(void);
+
+// Mark the start and end of the control step so its timing can be measured
+void control_loop_step_begin(void);
+void control_loop_step_end(void);
+
+// Get a snapshot of the timing of the steps since the stats were last reset
+struct ControlLoopStats control_loop_get_stats(void);
+
+// Clear the stats (e.g. after reporting them) so they show the most recent behaviour
+void control_loop_reset_stats(void);
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * dock.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "dock.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+/// @brief Find how far short of the dock and to the left of its line a position is
+/// @param x The x position (in mm)
+/// @param y The y position (in mm)
+/// @param along Filled in with the distance short of the dock (in mm)
+/// @param across Filled in with the distance to the left of the line (in mm)
+void to_line(long x, long y, long * along, long * across);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+// the dock, and which way its line goes
+long dock_x = 0;
+long dock_y = 0;
+fix16_t dock_heading = 0;
+fix16_t dock_cos = FIX16_ONE;
+fix16_t dock_sin = 0;
+
+// the estimate of where the robot is relative to the line (mm), and the speed it was last told to drive (cm/s)
+fix16_t dock_along = 0;
+fix16_t dock_across = 0;
+fix16_t dock_linear = 0;
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void dock_staging_point(long dockX, long dockY, fix16_t heading, long * x, long * y)
+{
+    // back from the dock, the way the robot will be facing once it's in
+    *x = dockX - FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(DOCK_STAGING_DISTANCE), fix16_cos(heading)));
+    *y = dockY - FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(DOCK_STAGING_DISTANCE), fix16_sin(heading)));
+}
+
+void dock_start(long dockX, long dockY, fix16_t heading, struct Pose pose)
+{
+    long along, across;
+
+    dock_x = dockX;
+    dock_y = dockY;
+    dock_heading = heading;
+    dock_cos = fix16_cos(heading);
+    dock_sin = fix16_sin(heading);
+
+    to_line(pose.x, pose.y, &along, &across);
+    dock_along = FIX16_FROM_INT(along);
+    dock_across = FIX16_FROM_INT(across);
+    dock_linear = 0;
+}
+
+struct DockCommand dock_step(struct Pose pose, long range, fix16_t dt)
+{
+    struct DockCommand command = {0, 0, 0};
+    fix16_t error = fix16_wrap_angle(pose.heading - dock_heading);
+    long along, across;
+
+    // predict from what the robot was told to drive (cm/s to mm), then pull towards the pose
+    fix16_t travelled = fix16_mul(dock_linear * 10, dt);
+    dock_along -= fix16_mul(travelled, fix16_cos(error));
+    dock_across += fix16_mul(travelled, fix16_sin(error));
+
+    to_line(pose.x, pose.y, &along, &across);
+    dock_along += fix16_mul(FIX16_FROM_INT(along) - dock_along, DOCK_POSE_FILTER);
+    dock_across += fix16_mul(FIX16_FROM_INT(across) - dock_across, DOCK_POSE_FILTER);
+
+    // the range is far better than the UWB, but only once it's the dock face the sensor is looking at
+    if(range >= 0 && error < DOCK_RANGE_ANGLE && error > -DOCK_RANGE_ANGLE)
+    {
+        fix16_t measured = FIX16_FROM_INT(range - DOCK_FACE_DISTANCE);
+        if(abs(FIX16_TO_INT(measured - dock_along)) <= DOCK_RANGE_AGREEMENT)
+            dock_along += fix16_mul(measured - dock_along, DOCK_RANGE_FILTER);
+    }
+
+    if(dock_along <= FIX16_FROM_INT(DOCK_TOLERANCE))
+    {
+        command.done = 1;
+        dock_linear = 0;
+        return command;
+    }
+
+    // facing well away from the line (e.g. it came in from the side), so turn to it on the spot first
+    if(error > DOCK_TURN_ANGLE || error < -DOCK_TURN_ANGLE)
+    {
+        command.angular = error > 0 ? -DOCK_TURN_RATE : DOCK_TURN_RATE;
+        dock_linear = 0;
+        return command;
+    }
+
+    // steer for a point on the line a fixed distance ahead, so it's back on the line well before the dock
+    fix16_t target = fix16_atan2(-dock_across, FIX16_FROM_INT(DOCK_LOOKAHEAD));
+    command.angular = fix16_mul(fix16_wrap_angle(target - error), DOCK_STEER_GAIN);
+    if(command.angular > DOCK_TURN_RATE)
+        command.angular = DOCK_TURN_RATE;
+    else if(command.angular < -DOCK_TURN_RATE)
+        command.angular = -DOCK_TURN_RATE;
+
+    // slowing in proportion to the distance left, down to a creep
+    command.linear = fix16_mul(DOCK_MAX_SPEED, fix16_div(dock_along, FIX16_FROM_INT(DOCK_SLOW_DISTANCE)));
+    if(command.linear > DOCK_MAX_SPEED)
+        command.linear = DOCK_MAX_SPEED;
+    else if(command.linear < DOCK_MIN_SPEED)
+        command.linear = DOCK_MIN_SPEED;
+
+    dock_linear = command.linear;
+    return command;
+}
+
+void dock_get_error(long * along, long * across)
+{
+    *along = FIX16_TO_INT(dock_along);
+    *across = FIX16_TO_INT(dock_across);
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+void to_line(long x, long y, long * along, long * across)
+{
+    long dx = dock_x - x;
+    long dy = dock_y - y;
+
+    // the line runs into the dock along its heading
+    *along = FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(dx), dock_cos) + fix16_mul(FIX16_FROM_INT(dy), dock_sin));
+    *across = FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(dx), dock_sin) - fix16_mul(FIX16_FROM_INT(dy), dock_cos));
+}
\ No newline at end of file
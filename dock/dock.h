@@ -0,0 +1,56 @@
+/*
+ * dock.h
+ * Final approach to the dock at home, finishing lined up with it to within a few cm
+ *
+ * The approach starts DOCK_STAGING_DISTANCE out from the dock, on the line the robot drives in along. Where the robot
+ * is along and across that line is filtered: it is predicted from the speed driven, and pulled a little towards each
+ * new pose (so the ~100mm jumps of the UWB are smoothed out) and more strongly towards the centre ultrasonic's range to
+ * the dock face once that agrees with it (the range is good to a few mm)
+ *
+ * The robot steers for a point on the line a little ahead of it, so it eases onto the line rather than stopping to turn
+ * back onto it, and slows down steadily the closer it gets so it can finish on the mark without stopping short to correct
+ *
+ * Created: 2026-10-19
+ */
+#ifndef DOCKH
+#define DOCKH
+
+#include "pico/stdlib.h"
+#include "../fixed/fixed.h"
+#include "../pose/pose.h"
+
+#define DOCK_STAGING_DISTANCE   600                         // mm out from the dock the approach starts
+#define DOCK_FACE_DISTANCE      250                         // mm from the robot's centre to the dock face once docked
+#define DOCK_TOLERANCE          20                          // mm short of the dock that counts as docked
+#define DOCK_SLOW_DISTANCE      400                         // mm from the dock the robot starts to slow down
+#define DOCK_MAX_SPEED          FIX16_FROM_INT(20)          // cm/s
+#define DOCK_MIN_SPEED          FIX16_FROM_INT(4)           // cm/s, creeping in at the end (still enough to keep the wheels turning)
+#define DOCK_LOOKAHEAD          130                         // mm ahead on the line the robot steers for
+#define DOCK_STEER_GAIN         FIX16_FROM_FLOAT(2.0)       // rad/s for every rad the robot is off the point it's steering for
+#define DOCK_TURN_RATE          FIX16_FROM_FLOAT(1.0)       // rad/s, fastest it turns
+#define DOCK_TURN_ANGLE         FIX16_FROM_FLOAT(0.785398)  // rad off the line's heading (45 degrees) before it turns on the spot instead
+#define DOCK_POSE_FILTER        FIX16_FROM_FLOAT(0.05)      // fraction of the difference to the pose taken each step
+#define DOCK_RANGE_FILTER       FIX16_FROM_FLOAT(0.3)       // fraction of the difference to each new range taken
+#define DOCK_RANGE_AGREEMENT    150                         // mm the range can be from the estimate and still be trusted
+#define DOCK_RANGE_ANGLE        FIX16_FROM_FLOAT(0.26)      // rad off the line's heading (15 degrees) the range is still square to the face
+
+struct DockCommand {
+    bool done;          // 1 once docked (or past it), the robot should stop
+    fix16_t linear;     // cm/s
+    fix16_t angular;    // rad/s, counter-clockwise
+};
+
+// Get where the approach to a dock (at a position in mm, facing the heading in rad once docked) starts
+void dock_staging_point(long dockX, long dockY, fix16_t heading, long * x, long * y);
+
+// Start the approach to a dock (at a position in mm, facing the heading in rad once docked) from the robot's pose
+void dock_start(long dockX, long dockY, fix16_t heading, struct Pose pose);
+
+// Work out how to drive for the next step (of dt s), from the pose and a range (in mm from the robot's centre) to the
+// dock face if the centre ultrasonic has a new one (-1 if not)
+struct DockCommand dock_step(struct Pose pose, long range, fix16_t dt);
+
+// Get how far short of the dock (in mm) and to the left of its line (in mm) the robot is estimated to be
+void dock_get_error(long * along, long * across);
+
+#endif
\ No newline at end of file
@@ -11,8 +11,10 @@
 #include <string.h>
 
 volatile int request_begin = 0;
-volatile int request_finish = 0;
 volatile char dataBuff[200] = "";
+// when the request was sent, and the type of value being read from the response (the error code, then the position)
+volatile uint64_t request_time = 0;
+volatile char expectType = 0x40;
 
 volatile unsigned char byteCount = 0;
 // max number of bytes to be read, at most is 253
@@ -28,6 +30,8 @@ volatile unsigned char maxLength = 253;
 // which is followed by a byte indicating the number of bytes in the response
 // which is followed by the specified number of bytes
 // the buff will contain those response bytes only
+// only reads what has already come in, carrying on from where the last call left off
+// returns 1 once the whole value has been read, 0 if there's more to come, -1 if it isn't the expected type
 int read_value(char expect_type, char * buff);
 
 // Parse out a coordinate (x, y, z) as a 32 bit integer, starting from the startIdx of the buff, made up of individual 4 bytes
@@ -59,7 +63,7 @@ void dwm1001_init_communication(void)
 
 struct DWM1001_Position dwm1001_request_position(void)
 {
-    char error;
+    int result = 0;
     struct DWM1001_Position coords;
     coords.x = 0;
     coords.y = 0;
@@ -68,8 +72,16 @@ struct DWM1001_Position dwm1001_request_position(void)
 
     if(!request_begin)
     {
+        // anything left over from a response that came too late would be mistaken for this one's
+        while(uart_is_readable(DWM1001_UART_ID))
+            uart_getc(DWM1001_UART_ID);
+
         strcpy(dataBuff, "");
         request_begin = 1;
+        request_time = time_us_64();
+        expectType = 0x40;
+        maxLength = 253;
+        byteCount = 0;
         // dwm_loc_get      see 5.3.10
         uart_putc_raw(DWM1001_UART_ID, 0x02);
         uart_putc_raw(DWM1001_UART_ID, 0x00);
@@ -77,47 +89,40 @@ struct DWM1001_Position dwm1001_request_position(void)
     }
     else
     {
-        maxLength = 253;
-        byteCount = 0;
-        //check if there's an error in the command
-        do
-        {
-            error = read_value(0x40, dataBuff);
-        } while(!error && !request_finish);
-
-        // printf("\nread error state");
-
-        if(!error) 
+        //check if there's an error in the command, then get the device's position
+        //(whatever hasn't come in yet is read next time)
+        result = read_value(expectType, dataBuff);
+        if(result == 1 && expectType == 0x40)
         {
             // printf("\nno error");
-            request_finish = 0;
+            expectType = 0x41;
             maxLength = 253;
             byteCount = 0;
-            // get the device's position
-            do
-            {
-                error = read_value(0x41, dataBuff);
-            } while(!error && !request_finish);
-            // printf("\nread data");
+            result = read_value(expectType, dataBuff);
+        }
 
-            if(!error) 
-            {
-                // printf("\nno error");
-                coords.set = 1;
-                // first 4 bytes are x, next 4 are y, next 4 are z, last 1 is quality(?)
-                // bytes represent 32 bit integer (measuring mm)
-                // example: 0x08 0x00 0x00 0x00    0x0B 0xFF 0xFF 0xFF    0x4C 0x00 0x00 0x00    0x00
-                // bytes come in reverse order (LSByte first)
-                // ~ x = -0.06, y = -0.03, z = 0.08
-
-                // Current expected values:
-                // x = 2.25m, y = 0, z = 0
-                coords.x = read_coord(dataBuff, 0);
-                coords.y = read_coord(dataBuff, 4);
-                coords.z = read_coord(dataBuff, 8);
-            }
+        if(result == 1)
+        {
+            // printf("\nread data");
+            coords.set = 1;
+            // first 4 bytes are x, next 4 are y, next 4 are z, last 1 is quality(?)
+            // bytes represent 32 bit integer (measuring mm)
+            // example: 0x08 0x00 0x00 0x00    0x0B 0xFF 0xFF 0xFF    0x4C 0x00 0x00 0x00    0x00
+            // bytes come in reverse order (LSByte first)
+            // ~ x = -0.06, y = -0.03, z = 0.08
+
+            // Current expected values:
+            // x = 2.25m, y = 0, z = 0
+            coords.x = read_coord(dataBuff, 0);
+            coords.y = read_coord(dataBuff, 4);
+            coords.z = read_coord(dataBuff, 8);
+            request_begin = 0;
+        }
+        // an error, or no answer at all (e.g. the module isn't there), so ask again
+        else if(result == -1 || time_us_64() - request_time >= DWM1001_RESPONSE_TIMEOUT)
+        {
+            request_begin = 0;
         }
-        request_begin = 0;
     }
         
     return coords;
@@ -129,8 +134,6 @@ struct DWM1001_Position dwm1001_request_position(void)
 
 int read_value(char expect_type, char * buff)
 {
-    while(!uart_is_readable(DWM1001_UART_ID));
-    
     // while there's data to read and we haven't read the end of this value (read all bytes indicated in value)
     while(uart_is_readable(DWM1001_UART_ID) && byteCount < maxLength + 2)
     {
@@ -148,15 +151,14 @@ int read_value(char expect_type, char * buff)
         {
             maxLength = c;
         }
-        else
+        // (the value carries on from wherever the last call got to)
+        else if(byteCount - 3 < sizeof(dataBuff))
         {
-            *buff = c;
-            ++buff;
-            if(byteCount == maxLength + 2) request_finish = 1;
+            buff[byteCount - 3] = c;
         }
     }
 
-    return 0;
+    return byteCount == maxLength + 2 ? 1 : 0;
 }
 
 long read_coord(char * buff, int startIdx)
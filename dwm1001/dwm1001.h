@@ -21,6 +21,8 @@
 #define DWM1001_STOP_BITS 1
 #define DWM1001_PARITY    UART_PARITY_NONE
 
+#define DWM1001_RESPONSE_TIMEOUT 100000 // 100ms (in us) for the module to answer before the request is sent again
+
 struct DWM1001_Position {
     long x; //mm
     long y; //mm
@@ -31,8 +33,9 @@ struct DWM1001_Position {
 // Initialize the UART Channel 1 with a baud rate of 115200 for communication with the DWM1001 dev board
 void dwm1001_init_communication(void);
 
-// Send a request to the DWM1001 module for dwm_loc_get
-// Return the x/y/z coordinates returned as long values (in mm) on position struct
+// Send a request to the DWM1001 module for dwm_loc_get, or read as much of its response as has come in (never waits on the UART)
+// Return the x/y/z coordinates returned as long values (in mm) on position struct, set once the whole response has been read
+// (a module that doesn't answer within DWM1001_RESPONSE_TIMEOUT is asked again)
 struct DWM1001_Position dwm1001_request_position(void);
 
 #endif
\ No newline at end of file
@@ -9,6 +9,10 @@
 typedef enum
 {
 	Encoder_FL = 0, // front left wheel
-	Encoder_FR = 1  // front right wheel
+	Encoder_FR = 1, // front right wheel
+	Encoder_ML = 2, // middle left wheel
+	Encoder_MR = 3, // middle right wheel
+	Encoder_BL = 4, // back left wheel
+	Encoder_BR = 5  // back right wheel
 } Encoder_Motor;
 
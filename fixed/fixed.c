@@ -0,0 +1,155 @@
+/*
+ * fixed.c
+ *
+ * Created: 2026-10-19
+ */
+#include "pico/stdlib.h"
+#include "fixed.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+#define FIX16_INV_TWO_PI 10430 // 1 / 2pi in Q16.16, turns radians into a fraction of a full turn
+
+/// @brief Approximate atan for a ratio between 0 and 1
+/// @param z The ratio (y/x) in Q16.16, 0 to FIX16_ONE
+/// @return The angle, in radians (0 to pi/4)
+fix16_t atan_unit(fix16_t z);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+// sin from 0 to pi/2 in 64 steps (Q16.16)
+const int32_t sin_table[65] = {
+    0, 1608, 3216, 4821, 6424, 8022, 9616, 11204,
+    12785, 14359, 15924, 17479, 19024, 20557, 22078, 23586,
+    25080, 26558, 28020, 29466, 30893, 32303, 33692, 35062,
+    36410, 37736, 39040, 40320, 41576, 42806, 44011, 45190,
+    46341, 47464, 48559, 49624, 50660, 51665, 52639, 53581,
+    54491, 55368, 56212, 57022, 57798, 58538, 59244, 59914,
+    60547, 61145, 61705, 62228, 62714, 63162, 63572, 63944,
+    64277, 64571, 64827, 65043, 65220, 65358, 65457, 65516,
+    65536
+};
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+fix16_t fix16_mul(fix16_t a, fix16_t b)
+{
+    int64_t product = (int64_t) a * b;
+    // round to nearest rather than always towards negative infinity
+    return (fix16_t) ((product + (FIX16_ONE >> 1)) >> 16);
+}
+
+fix16_t fix16_div(fix16_t a, fix16_t b)
+{
+    if(b == 0)
+        return a >= 0 ? FIX16_MAX : FIX16_MIN;
+
+    return (fix16_t) (((int64_t) a << 16) / b);
+}
+
+
+fix16_t fix16_sqrt(fix16_t a)
+{
+    if(a <= 0)
+        return 0;
+
+    // sqrt(a * 2^16) is the fixed point result, found a bit at a time
+    uint64_t value = (uint64_t) a << 16;
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t) 1 << 46;
+
+    while(bit > value)
+        bit >>= 2;
+
+    while(bit != 0)
+    {
+        if(value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (fix16_t) result;
+}
+
+fix16_t fix16_wrap_angle(fix16_t angle)
+{
+    angle %= FIX16_TWO_PI;
+    if(angle > FIX16_PI)
+        angle -= FIX16_TWO_PI;
+    else if(angle < -FIX16_PI)
+        angle += FIX16_TWO_PI;
+    return angle;
+}
+
+fix16_t fix16_sin(fix16_t angle)
+{
+    angle %= FIX16_TWO_PI;
+    if(angle < 0)
+        angle += FIX16_TWO_PI;
+
+    // fraction of a full turn, as 16 bits (the product only just fits in 32 bits unsigned)
+    uint32_t turn = ((uint32_t) angle * FIX16_INV_TWO_PI) >> 16;
+    uint32_t quadrant = (turn >> 14) & 3;
+    uint32_t position = turn & 0x3FFF;
+
+    // the second half of each half wave is the first half mirrored
+    if(quadrant & 1)
+        position = 0x4000 - position;
+
+    uint32_t index = position >> 8;
+    int32_t value = sin_table[index];
+    if(index < 64)
+        value += ((sin_table[index + 1] - value) * (int32_t) (position & 0xFF)) >> 8;
+
+    return quadrant & 2 ? -value : value;
+}
+
+fix16_t fix16_cos(fix16_t angle)
+{
+    return fix16_sin(angle + FIX16_HALF_PI);
+}
+
+fix16_t fix16_atan2(fix16_t y, fix16_t x)
+{
+    fix16_t absX = x < 0 ? -x : x;
+    fix16_t absY = y < 0 ? -y : y;
+    fix16_t angle;
+
+    if(absX == 0 && absY == 0)
+        return 0;
+
+    // keep the ratio between 0 and 1 so the approximation stays accurate
+    if(absX >= absY)
+        angle = atan_unit(fix16_div(absY, absX));
+    else
+        angle = FIX16_HALF_PI - atan_unit(fix16_div(absX, absY));
+
+    if(x < 0)
+        angle = FIX16_PI - angle;
+
+    return y < 0 ? -angle : angle;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+fix16_t atan_unit(fix16_t z)
+{
+    // atan(z) ~= pi/4 * z + 0.273 * z * (1 - z)
+    return fix16_mul(FIX16_FROM_FLOAT(0.785398), z) +
+           fix16_mul(FIX16_FROM_FLOAT(0.273), fix16_mul(z, FIX16_ONE - z));
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+/*
+ * fixed.h
+ * Q16.16 fixed point math, since the RP2040 has no FPU and every float operation is done in software
+ *
+ * Constants should be converted with FIX16_FROM_FLOAT on a constant expression so the compiler
+ * folds them at build time, leaving only integer math at runtime
+ *
+ * Created: 2026-10-19
+ */
+#ifndef FIXEDH
+#define FIXEDH
+
+#include <stdint.h>
+
+typedef int32_t fix16_t;
+
+#define FIX16_ONE       0x00010000
+#define FIX16_MAX       0x7FFFFFFF
+#define FIX16_MIN       ((fix16_t) 0x80000000)
+
+#define FIX16_PI        205887 // pi in Q16.16
+#define FIX16_HALF_PI   102944
+#define FIX16_TWO_PI    411775
+
+// Convert at compile time (only use these on constants, the float math is folded away by the compiler)
+#define FIX16_FROM_FLOAT(x) ((fix16_t) ((x) >= 0 ? ((x) * FIX16_ONE + 0.5) : ((x) * FIX16_ONE - 0.5)))
+#define FIX16_FROM_INT(x)   ((fix16_t) ((x) * FIX16_ONE))
+
+// Convert back to a whole number, rounding to the nearest
+#define FIX16_TO_INT(x)     ((x) >= 0 ? (((x) + (FIX16_ONE >> 1)) >> 16) : -((-(x) + (FIX16_ONE >> 1)) >> 16))
+
+// Multiply two fixed point values
+fix16_t fix16_mul(fix16_t a, fix16_t b);
+
+// Divide two fixed point values, saturating to FIX16_MAX/FIX16_MIN when dividing by 0
+fix16_t fix16_div(fix16_t a, fix16_t b);
+
+// Square root (negative values give 0)
+fix16_t fix16_sqrt(fix16_t a);
+
+// Wrap an angle (in radians) to between -pi and pi
+fix16_t fix16_wrap_angle(fix16_t angle);
+
+// Sine/cosine of an angle (in radians), from a quarter wave table with linear interpolation (error < 0.0005)
+fix16_t fix16_sin(fix16_t angle);
+fix16_t fix16_cos(fix16_t angle);
+
+// Angle (in radians, between -pi and pi) of the vector x,y -- both only need to be in the same units (error < 0.005 rad)
+fix16_t fix16_atan2(fix16_t y, fix16_t x);
+
+#endif
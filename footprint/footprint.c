@@ -0,0 +1,264 @@
+/*
+ * footprint.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "footprint.h"
+#include "../grid/grid.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+// Cells either side of the one a circle's centre is in that the circle can reach into
+#define FOOTPRINT_DISK_CELLS    ((FOOTPRINT_RADIUS + GRID_CELL_SIZE / 2) / GRID_CELL_SIZE + 1)
+#define FOOTPRINT_DISK_MAX      ((2 * FOOTPRINT_DISK_CELLS + 1) * (2 * FOOTPRINT_DISK_CELLS + 1))
+
+struct FootprintPoint {
+    long x;         // mm
+    long y;         // mm
+    uint64_t time;  // us, when it was seen (0 if the place is empty)
+};
+
+/// @brief Find the arc in the table closest to the one the speeds would drive
+/// @param linear The forward speed (in cm/s, more than 0)
+/// @param angular The turn rate (in rad/s, counter-clockwise)
+/// @return The index of the arc
+int arc_index(fix16_t linear, fix16_t angular);
+
+/// @brief Check if a point (in the robot's frame, in mm) is within a distance of any of the circles at a step along an arc
+/// @param arc The index of the arc
+/// @param step The index of the step along the arc
+/// @param x The x position of the point (mm ahead of the robot)
+/// @param y The y position of the point (mm to the left of the robot)
+/// @param radius The distance (in mm)
+/// @return 1 if it is
+bool touches(int arc, int step, long x, long y, long radius);
+
+/// @brief Check if a circle at a position (in mm) overlaps an occupied cell the robot isn't already touching
+/// @param x The x position of the circle's centre
+/// @param y The y position of the circle's centre
+/// @param robotX The x position of the robot (in mm)
+/// @param robotY The y position of the robot (in mm)
+/// @param cosine The cosine of the robot's heading
+/// @param sine The sine of the robot's heading
+/// @return 1 if it does
+bool overlaps_map(long x, long y, long robotX, long robotY, fix16_t cosine, fix16_t sine);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+// where the centre of each circle is at each step along each arc (mm, ahead of and to the left of where the robot starts)
+int16_t arc_x[FOOTPRINT_ARCS][FOOTPRINT_STEPS][FOOTPRINT_CIRCLES];
+int16_t arc_y[FOOTPRINT_ARCS][FOOTPRINT_STEPS][FOOTPRINT_CIRCLES];
+
+// offsets of the cells around a circle's cell that it could reach into
+int8_t disk_columns[FOOTPRINT_DISK_MAX];
+int8_t disk_rows[FOOTPRINT_DISK_MAX];
+int disk_count = 0;
+
+// the recent obstacle points, and where the next one goes
+struct FootprintPoint footprint_points[FOOTPRINT_MAX_POINTS];
+int footprint_next = 0;
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void footprint_init(void)
+{
+    int arc, step, circle, column, row;
+
+    for(arc = 0; arc < FOOTPRINT_ARCS; ++arc)
+    {
+        fix16_t curvature = (arc - FOOTPRINT_ARCS / 2) * FOOTPRINT_CURVATURE_STEP; // rad/m
+
+        for(step = 0; step < FOOTPRINT_STEPS; ++step)
+        {
+            fix16_t distance = FIX16_FROM_INT(step * FOOTPRINT_STEP) / 1000;   // m
+            fix16_t angle = fix16_mul(curvature, distance);
+            fix16_t centreX = distance;
+            fix16_t centreY = 0;
+
+            // round the circle of radius 1/curvature (a straight line if there's no curvature)
+            if(curvature != 0)
+            {
+                centreX = fix16_div(fix16_sin(angle), curvature);
+                centreY = fix16_div(FIX16_ONE - fix16_cos(angle), curvature);
+            }
+
+            for(circle = 0; circle < FOOTPRINT_CIRCLES; ++circle)
+            {
+                // the circles are along the robot, which is facing along the arc
+                fix16_t offset = FIX16_FROM_INT((circle - FOOTPRINT_CIRCLES / 2) * FOOTPRINT_SPACING) / 1000;
+                arc_x[arc][step][circle] = FIX16_TO_INT((centreX + fix16_mul(offset, fix16_cos(angle))) * 1000);
+                arc_y[arc][step][circle] = FIX16_TO_INT((centreY + fix16_mul(offset, fix16_sin(angle))) * 1000);
+            }
+        }
+    }
+
+    // the centre of a circle can be anywhere in its cell, so take every cell it could reach from some part of it
+    disk_count = 0;
+    for(row = -FOOTPRINT_DISK_CELLS; row <= FOOTPRINT_DISK_CELLS; ++row)
+    {
+        for(column = -FOOTPRINT_DISK_CELLS; column <= FOOTPRINT_DISK_CELLS; ++column)
+        {
+            long gapX = (abs(column) > 0 ? abs(column) - 1 : 0) * GRID_CELL_SIZE;
+            long gapY = (abs(row) > 0 ? abs(row) - 1 : 0) * GRID_CELL_SIZE;
+            if(gapX * gapX + gapY * gapY < (long) FOOTPRINT_RADIUS * FOOTPRINT_RADIUS)
+            {
+                disk_columns[disk_count] = column;
+                disk_rows[disk_count] = row;
+                ++disk_count;
+            }
+        }
+    }
+
+    footprint_clear();
+}
+
+void footprint_clear(void)
+{
+    int index;
+
+    for(index = 0; index < FOOTPRINT_MAX_POINTS; ++index)
+        footprint_points[index].time = 0;
+    footprint_next = 0;
+}
+
+void footprint_add_point(long x, long y, uint64_t time)
+{
+    footprint_points[footprint_next].x = x;
+    footprint_points[footprint_next].y = y;
+    footprint_points[footprint_next].time = time;
+    footprint_next = (footprint_next + 1) % FOOTPRINT_MAX_POINTS;
+}
+
+long footprint_free_distance(long x, long y, fix16_t heading, fix16_t linear, fix16_t angular, uint64_t now)
+{
+    long pointX[FOOTPRINT_MAX_POINTS];
+    long pointY[FOOTPRINT_MAX_POINTS];
+    int count = 0;
+    int index, step, circle;
+
+    if(linear <= 0)
+        return FOOTPRINT_HORIZON;
+
+    int arc = arc_index(linear, angular);
+    fix16_t cosine = fix16_cos(heading);
+    fix16_t sine = fix16_sin(heading);
+
+    // turn the recent points into the robot's frame once, so they can be compared with the table directly
+    for(index = 0; index < FOOTPRINT_MAX_POINTS; ++index)
+    {
+        struct FootprintPoint * point = &footprint_points[index];
+        long dx = point->x - x;
+        long dy = point->y - y;
+
+        if(point->time == 0 || now - point->time > FOOTPRINT_POINT_AGE)
+            continue;
+        if(labs(dx) > FOOTPRINT_REACH || labs(dy) > FOOTPRINT_REACH)
+            continue;
+
+        long ahead = FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(dx), cosine) + fix16_mul(FIX16_FROM_INT(dy), sine));
+        long left = FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(dy), cosine) - fix16_mul(FIX16_FROM_INT(dx), sine));
+        if(touches(arc, 0, ahead, left, FOOTPRINT_RADIUS))
+            continue;
+
+        pointX[count] = ahead;
+        pointY[count] = left;
+        ++count;
+    }
+
+    for(step = 1; step < FOOTPRINT_STEPS; ++step)
+    {
+        for(circle = 0; circle < FOOTPRINT_CIRCLES; ++circle)
+        {
+            long circleX = arc_x[arc][step][circle];
+            long circleY = arc_y[arc][step][circle];
+
+            for(index = 0; index < count; ++index)
+            {
+                long dx = pointX[index] - circleX;
+                long dy = pointY[index] - circleY;
+                if(dx * dx + dy * dy < (long) FOOTPRINT_RADIUS * FOOTPRINT_RADIUS)
+                    return (step - 1) * FOOTPRINT_STEP;
+            }
+
+            // back into UWB coordinates to look it up on the grid
+            long mapX = x + FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(circleX), cosine) - fix16_mul(FIX16_FROM_INT(circleY), sine));
+            long mapY = y + FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(circleX), sine) + fix16_mul(FIX16_FROM_INT(circleY), cosine));
+            if(overlaps_map(mapX, mapY, x, y, cosine, sine))
+                return (step - 1) * FOOTPRINT_STEP;
+        }
+    }
+    return FOOTPRINT_HORIZON;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+int arc_index(fix16_t linear, fix16_t angular)
+{
+    // curvature (rad/m) is the turn rate over the speed (cm/s, so 100x the speed in m/s)
+    fix16_t curvature = fix16_div(angular, linear / 100);
+    int arc = FIX16_TO_INT(fix16_div(curvature, FOOTPRINT_CURVATURE_STEP)) + FOOTPRINT_ARCS / 2;
+
+    // tighter than the table goes, so use the tightest there is
+    if(arc < 0)
+        return 0;
+    if(arc >= FOOTPRINT_ARCS)
+        return FOOTPRINT_ARCS - 1;
+    return arc;
+}
+
+bool touches(int arc, int step, long x, long y, long radius)
+{
+    int circle;
+
+    for(circle = 0; circle < FOOTPRINT_CIRCLES; ++circle)
+    {
+        long dx = x - arc_x[arc][step][circle];
+        long dy = y - arc_y[arc][step][circle];
+        if(dx * dx + dy * dy < radius * radius)
+            return 1;
+    }
+    return 0;
+}
+
+bool overlaps_map(long x, long y, long robotX, long robotY, fix16_t cosine, fix16_t sine)
+{
+    // (anything past the cell's corner can't be in the cell)
+    const long reach = FOOTPRINT_RADIUS + GRID_CELL_SIZE / 2;
+    int centreColumn, centreRow, index;
+
+    if(!grid_cell_from_position(x, y, &centreColumn, &centreRow))
+        return 0;
+
+    for(index = 0; index < disk_count; ++index)
+    {
+        int column = centreColumn + disk_columns[index];
+        int row = centreRow + disk_rows[index];
+        long cellX, cellY;
+
+        if(grid_get_cell(column, row) != Grid_Cell_Occupied)
+            continue;
+
+        grid_position_from_cell(column, row, &cellX, &cellY);
+        if((cellX - x) * (cellX - x) + (cellY - y) * (cellY - y) >= reach * reach)
+            continue;
+
+        // something the robot is already up against doesn't count (the bumpers and the histogram look after that)
+        long dx = cellX - robotX;
+        long dy = cellY - robotY;
+        long ahead = FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(dx), cosine) + fix16_mul(FIX16_FROM_INT(dy), sine));
+        long left = FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(dy), cosine) - fix16_mul(FIX16_FROM_INT(dx), sine));
+        if(!touches(0, 0, ahead, left, reach))
+            return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+/*
+ * footprint.h
+ * Collision checking with the whole of the robot's body, along the arc it's about to drive
+ *
+ * The body is covered by FOOTPRINT_CIRCLES circles along its length (together they cover the 300mm x 340mm chassis),
+ * so checking a point against it is a few distance comparisons whatever way the robot is facing
+ * The positions of the circles along arcs of FOOTPRINT_ARCS curvatures, every FOOTPRINT_STEP mm out to FOOTPRINT_HORIZON,
+ * are worked out once by footprint_init. A check then picks the arc closest to the one being driven and tests the circles
+ * at each step against the recent obstacle points (where the ultrasonics got returns from, kept for FOOTPRINT_POINT_AGE
+ * so things that have gone out of view still count) and the occupied cells of the grid
+ *
+ * Only driving forward is checked, the robot only reverses while recovering (when the bumpers watch the back)
+ *
+ * Created: 2026-10-19
+ */
+#ifndef FOOTPRINTH
+#define FOOTPRINTH
+
+#include "pico/stdlib.h"
+#include "../fixed/fixed.h"
+
+#define FOOTPRINT_CIRCLES           3
+#define FOOTPRINT_SPACING           100     // mm between the centres of the circles (the middle one is the robot's centre)
+#define FOOTPRINT_RADIUS            200     // mm, covers the corners of the chassis with 20mm to spare
+#define FOOTPRINT_STEP              75      // mm along the arc between checks
+#define FOOTPRINT_HORIZON           750     // mm along the arc that is checked
+#define FOOTPRINT_STEPS             (FOOTPRINT_HORIZON / FOOTPRINT_STEP + 1)
+#define FOOTPRINT_ARCS              17      // curvatures in the table (odd, so straight ahead is one of them)
+#define FOOTPRINT_CURVATURE_STEP    FIX16_FROM_FLOAT(0.5)   // rad/m between the curvatures (+-4 rad/m at the ends)
+#define FOOTPRINT_MAX_POINTS        32      // recent obstacle points kept (the oldest is replaced)
+#define FOOTPRINT_POINT_AGE         2000000 // us an obstacle point is kept for (before drift makes it unreliable)
+
+// How far from the robot's centre an obstacle can be and still be reached within the horizon (in mm)
+#define FOOTPRINT_REACH             (FOOTPRINT_HORIZON + FOOTPRINT_SPACING * (FOOTPRINT_CIRCLES / 2) + FOOTPRINT_RADIUS)
+
+// Work out the positions of the circles along each arc (must be called before anything is checked)
+void footprint_init(void);
+
+// Forget all of the obstacle points
+void footprint_clear(void);
+
+// Add a point (in mm) where something was seen
+void footprint_add_point(long x, long y, uint64_t time);
+
+// Get how far (in mm) the robot can drive along the arc of the speeds (cm/s and rad/s) from a pose before any part of it
+// would touch an obstacle point or an occupied cell, FOOTPRINT_HORIZON if nothing is in the way
+// (anything the robot is already touching is left to the bumpers, or it could never move away from it)
+long footprint_free_distance(long x, long y, fix16_t heading, fix16_t linear, fix16_t angular, uint64_t now);
+
+#endif
\ No newline at end of file
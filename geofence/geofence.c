@@ -0,0 +1,329 @@
+/*
+ * geofence.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "geofence.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+#define GEOFENCE_CELLS      (GEOFENCE_WIDTH * GEOFENCE_HEIGHT)
+#define GEOFENCE_CELL_SIZE  (GRID_CELL_SIZE * GEOFENCE_SCALE) // mm
+
+/// @brief Mark the index cells a zone covers or crosses
+/// @param zone Which zone
+void index_zone(int zone);
+
+/// @brief Check if a point is inside a zone's polygon (crossing number)
+/// @param zone Which zone
+/// @param x Position of the point (mm)
+/// @param y Position of the point (mm)
+/// @return 1 if inside
+bool zone_contains(int zone, long x, long y);
+
+/// @brief Check if a segment crosses the edge of a zone, or is inside it
+/// @param zone Which zone
+/// @param startX Start of the segment (mm)
+/// @param startY Start of the segment (mm)
+/// @param endX End of the segment (mm)
+/// @param endY End of the segment (mm)
+/// @return 1 if any of the segment is in the zone
+bool zone_overlaps_segment(int zone, long startX, long startY, long endX, long endY);
+
+/// @brief Check if a segment passes through (or touches) a rectangle
+/// @param a Start of the segment
+/// @param b End of the segment
+/// @param minX Left edge of the rectangle
+/// @param minY Bottom edge of the rectangle
+/// @param maxX Right edge of the rectangle
+/// @param maxY Top edge of the rectangle
+/// @return 1 if they touch
+bool segment_hits_box(struct GeofencePoint a, struct GeofencePoint b, long minX, long minY, long maxX, long maxY);
+
+/// @brief Check if two segments cross (or touch)
+/// @return 1 if they do
+bool segments_cross(long ax, long ay, long bx, long by, long cx, long cy, long dx, long dy);
+
+/// @brief Which side of the line from a to b a point is on
+/// @return 1 to the left, -1 to the right, 0 on the line
+int side_of(long ax, long ay, long bx, long by, long x, long y);
+
+/// @brief Find the index cell a position is in
+/// @param x Position (mm)
+/// @param y Position (mm)
+/// @param index Filled in with the index of the cell
+/// @return 0 if the position is outside the index
+bool cell_from_position(long x, long y, int * index);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+struct GeofenceZones geofence_zones;
+
+// For each index cell, a bit for each zone that covers all of it, and for each zone whose edge crosses it
+uint8_t cells_inside[GEOFENCE_CELLS];
+uint8_t cells_crossed[GEOFENCE_CELLS];
+
+// A bit for each zone that keeps the robot out
+uint8_t keep_out_zones = 0;
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void geofence_clear(void)
+{
+    geofence_zones.count = 0;
+    keep_out_zones = 0;
+    memset(cells_inside, 0, sizeof(cells_inside));
+    memset(cells_crossed, 0, sizeof(cells_crossed));
+}
+
+int geofence_load(const struct GeofenceZones * zones)
+{
+    int zone;
+
+    geofence_clear();
+    for(zone = 0; zone < zones->count && zone < GEOFENCE_MAX_ZONES; ++zone)
+    {
+        const struct GeofenceZone * source = &zones->zones[zone];
+        if(source->count < 3 || source->count > GEOFENCE_MAX_VERTICES)
+            continue;
+
+        geofence_zones.zones[geofence_zones.count] = *source;
+        if(source->speed <= 0)
+            keep_out_zones |= 1 << geofence_zones.count;
+        index_zone(geofence_zones.count++);
+    }
+    return geofence_zones.count;
+}
+
+const struct GeofenceZones * geofence_get(void)
+{
+    return &geofence_zones;
+}
+
+fix16_t geofence_speed_limit(long x, long y)
+{
+    fix16_t limit = FIX16_ONE;
+    int index, zone;
+
+    if(!cell_from_position(x, y, &index))
+        return limit;
+
+    uint8_t inside = cells_inside[index];
+    uint8_t crossed = cells_crossed[index];
+
+    for(zone = 0; zone < geofence_zones.count; ++zone)
+    {
+        uint8_t bit = 1 << zone;
+        // only the zones whose edge is in this cell need the point tested against them
+        if((inside & bit) || ((crossed & bit) && zone_contains(zone, x, y)))
+        {
+            if(geofence_zones.zones[zone].speed < limit)
+                limit = geofence_zones.zones[zone].speed;
+        }
+    }
+    return limit < 0 ? 0 : limit;
+}
+
+bool geofence_segment_allowed(long startX, long startY, long endX, long endY)
+{
+    uint8_t nearby = 0;
+    int zone;
+
+    if(keep_out_zones == 0)
+        return 1;
+
+    // walk the index cells along the segment (half a cell at a time), gathering the keep out zones in or next to them
+    // (the neighbours catch a corner the segment clips between two steps)
+    long dx = endX - startX;
+    long dy = endY - startY;
+    long length = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+    int steps = length / (GEOFENCE_CELL_SIZE / 2) + 1;
+    int step, column, row;
+
+    for(step = 0; step <= steps; ++step)
+    {
+        int index;
+        if(!cell_from_position(startX + dx * step / steps, startY + dy * step / steps, &index))
+            continue;
+
+        if(cells_inside[index] & keep_out_zones)
+            return 0;
+
+        for(row = index / GEOFENCE_WIDTH - 1; row <= index / GEOFENCE_WIDTH + 1; ++row)
+        {
+            for(column = index % GEOFENCE_WIDTH - 1; column <= index % GEOFENCE_WIDTH + 1; ++column)
+            {
+                if(column >= 0 && row >= 0 && column < GEOFENCE_WIDTH && row < GEOFENCE_HEIGHT)
+                    nearby |= cells_inside[row * GEOFENCE_WIDTH + column] | cells_crossed[row * GEOFENCE_WIDTH + column];
+            }
+        }
+    }
+
+    // then test the segment exactly against each of them
+    nearby &= keep_out_zones;
+    for(zone = 0; nearby != 0; ++zone, nearby >>= 1)
+    {
+        if((nearby & 1) && zone_overlaps_segment(zone, startX, startY, endX, endY))
+            return 0;
+    }
+    return 1;
+}
+
+bool geofence_cell_blocked(int column, int row)
+{
+    if(column < 0 || row < 0 || column >= GEOFENCE_WIDTH || row >= GEOFENCE_HEIGHT)
+        return 0;
+
+    int index = row * GEOFENCE_WIDTH + column;
+    return ((cells_inside[index] | cells_crossed[index]) & keep_out_zones) != 0;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+void index_zone(int zone)
+{
+    const struct GeofenceZone * polygon = &geofence_zones.zones[zone];
+    long minX = polygon->vertices[0].x, maxX = minX;
+    long minY = polygon->vertices[0].y, maxY = minY;
+    int vertex, column, row;
+
+    for(vertex = 1; vertex < polygon->count; ++vertex)
+    {
+        if(polygon->vertices[vertex].x < minX) minX = polygon->vertices[vertex].x;
+        if(polygon->vertices[vertex].x > maxX) maxX = polygon->vertices[vertex].x;
+        if(polygon->vertices[vertex].y < minY) minY = polygon->vertices[vertex].y;
+        if(polygon->vertices[vertex].y > maxY) maxY = polygon->vertices[vertex].y;
+    }
+
+    // only the cells under the zone's bounding box can be touched by it
+    int firstColumn = (minX - GRID_ORIGIN_X) / GEOFENCE_CELL_SIZE;
+    int lastColumn = (maxX - GRID_ORIGIN_X) / GEOFENCE_CELL_SIZE;
+    int firstRow = (minY - GRID_ORIGIN_Y) / GEOFENCE_CELL_SIZE;
+    int lastRow = (maxY - GRID_ORIGIN_Y) / GEOFENCE_CELL_SIZE;
+
+    if(firstColumn < 0) firstColumn = 0;
+    if(firstRow < 0) firstRow = 0;
+    if(lastColumn >= GEOFENCE_WIDTH) lastColumn = GEOFENCE_WIDTH - 1;
+    if(lastRow >= GEOFENCE_HEIGHT) lastRow = GEOFENCE_HEIGHT - 1;
+
+    for(row = firstRow; row <= lastRow; ++row)
+    {
+        for(column = firstColumn; column <= lastColumn; ++column)
+        {
+            long left = GRID_ORIGIN_X + column * GEOFENCE_CELL_SIZE;
+            long bottom = GRID_ORIGIN_Y + row * GEOFENCE_CELL_SIZE;
+            int index = row * GEOFENCE_WIDTH + column;
+            bool crossed = 0;
+
+            for(vertex = 0; vertex < polygon->count && !crossed; ++vertex)
+            {
+                struct GeofencePoint next = polygon->vertices[(vertex + 1) % polygon->count];
+                crossed = segment_hits_box(polygon->vertices[vertex], next,
+                    left, bottom, left + GEOFENCE_CELL_SIZE, bottom + GEOFENCE_CELL_SIZE);
+            }
+
+            // a cell no edge crosses is either all in or all out, so its centre says which
+            if(crossed)
+                cells_crossed[index] |= 1 << zone;
+            else if(zone_contains(zone, left + GEOFENCE_CELL_SIZE / 2, bottom + GEOFENCE_CELL_SIZE / 2))
+                cells_inside[index] |= 1 << zone;
+        }
+    }
+}
+
+bool zone_contains(int zone, long x, long y)
+{
+    const struct GeofenceZone * polygon = &geofence_zones.zones[zone];
+    bool inside = 0;
+    int vertex, previous;
+
+    for(vertex = 0, previous = polygon->count - 1; vertex < polygon->count; previous = vertex++)
+    {
+        struct GeofencePoint a = polygon->vertices[vertex];
+        struct GeofencePoint b = polygon->vertices[previous];
+
+        // count the edges a ray to the right of the point crosses
+        if((a.y > y) != (b.y > y) &&
+           ((int64_t) (x - a.x) * (b.y - a.y) < (int64_t) (b.x - a.x) * (y - a.y)) == (b.y > a.y))
+            inside = !inside;
+    }
+    return inside;
+}
+
+bool zone_overlaps_segment(int zone, long startX, long startY, long endX, long endY)
+{
+    const struct GeofenceZone * polygon = &geofence_zones.zones[zone];
+    int vertex;
+
+    // a segment that doesn't cross any edge is either all in or all out
+    for(vertex = 0; vertex < polygon->count; ++vertex)
+    {
+        struct GeofencePoint a = polygon->vertices[vertex];
+        struct GeofencePoint b = polygon->vertices[(vertex + 1) % polygon->count];
+        if(segments_cross(startX, startY, endX, endY, a.x, a.y, b.x, b.y))
+            return 1;
+    }
+    return zone_contains(zone, startX, startY);
+}
+
+bool segment_hits_box(struct GeofencePoint a, struct GeofencePoint b, long minX, long minY, long maxX, long maxY)
+{
+    // off to one side of the box altogether
+    if((a.x < minX && b.x < minX) || (a.x > maxX && b.x > maxX) ||
+       (a.y < minY && b.y < minY) || (a.y > maxY && b.y > maxY))
+        return 0;
+
+    // otherwise it misses only if every corner is on the same side of the line
+    int sides = side_of(a.x, a.y, b.x, b.y, minX, minY) + side_of(a.x, a.y, b.x, b.y, maxX, minY) +
+                side_of(a.x, a.y, b.x, b.y, minX, maxY) + side_of(a.x, a.y, b.x, b.y, maxX, maxY);
+    return sides != 4 && sides != -4;
+}
+
+bool segments_cross(long ax, long ay, long bx, long by, long cx, long cy, long dx, long dy)
+{
+    int abC = side_of(ax, ay, bx, by, cx, cy);
+    int abD = side_of(ax, ay, bx, by, dx, dy);
+    int cdA = side_of(cx, cy, dx, dy, ax, ay);
+    int cdB = side_of(cx, cy, dx, dy, bx, by);
+
+    if(abC * abD > 0 || cdA * cdB > 0)
+        return 0;
+
+    // all four in a line: they only cross if they overlap
+    if(abC == 0 && abD == 0)
+    {
+        return (ax < cx ? ax : cx) <= (bx > dx ? bx : dx) && (cx < dx ? cx : dx) <= (ax > bx ? ax : bx) &&
+               (ay < cy ? ay : cy) <= (by > dy ? by : dy) && (cy < dy ? cy : dy) <= (ay > by ? ay : by);
+    }
+    return 1;
+}
+
+int side_of(long ax, long ay, long bx, long by, long x, long y)
+{
+    int64_t cross = (int64_t) (bx - ax) * (y - ay) - (int64_t) (by - ay) * (x - ax);
+    return cross > 0 ? 1 : cross < 0 ? -1 : 0;
+}
+
+bool cell_from_position(long x, long y, int * index)
+{
+    long offsetX = x - GRID_ORIGIN_X;
+    long offsetY = y - GRID_ORIGIN_Y;
+
+    if(offsetX < 0 || offsetY < 0 || offsetX >= GEOFENCE_WIDTH * GEOFENCE_CELL_SIZE || offsetY >= GEOFENCE_HEIGHT * GEOFENCE_CELL_SIZE)
+        return 0;
+
+    *index = offsetY / GEOFENCE_CELL_SIZE * GEOFENCE_WIDTH + offsetX / GEOFENCE_CELL_SIZE;
+    return 1;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+/*
+ * geofence.h
+ * Zones the robot has to keep out of (bathrooms, stair tops) or slow down in (rug edges)
+ *
+ * Each zone is a polygon in UWB coordinates (mm) with the fraction of full speed allowed inside it, 0 keeps the robot out
+ * When zones are loaded every index cell (GEOFENCE_SCALE x GEOFENCE_SCALE grid cells, the same as a planner cell) is
+ * marked with which zones cover it completely and which only cross it. A query then looks at its cell's marks, and only
+ * tests the point (or segment) against the polygons that cross the cell, so it takes the same time however many zones there are
+ *
+ * Created: 2026-10-19
+ */
+#ifndef GEOFENCEH
+#define GEOFENCEH
+
+#include "pico/stdlib.h"
+#include "../fixed/fixed.h"
+#include "../grid/grid.h"
+
+#define GEOFENCE_MAX_ZONES      8       // (one bit each in the index)
+#define GEOFENCE_MAX_VERTICES   16
+#define GEOFENCE_SCALE          2       // grid cells along each side of an index cell (200mm)
+#define GEOFENCE_WIDTH          (GRID_WIDTH / GEOFENCE_SCALE)
+#define GEOFENCE_HEIGHT         (GRID_HEIGHT / GEOFENCE_SCALE)
+#define GEOFENCE_VERSION        1       // format of struct GeofenceZones when it's saved
+
+struct GeofencePoint {
+    long x;     // mm
+    long y;     // mm
+};
+
+struct GeofenceZone {
+    uint8_t count;      // vertices used (at least 3)
+    fix16_t speed;      // fraction of full speed allowed inside (0 to keep out)
+    struct GeofencePoint vertices[GEOFENCE_MAX_VERTICES];
+};
+
+struct GeofenceZones {
+    uint8_t count;
+    struct GeofenceZone zones[GEOFENCE_MAX_ZONES];
+};
+
+// Remove all of the zones
+void geofence_clear(void);
+
+// Replace the zones and build the index over them (zones with fewer than 3 vertices are skipped), returns the number loaded
+int geofence_load(const struct GeofenceZones * zones);
+
+// Get the zones that are loaded
+const struct GeofenceZones * geofence_get(void);
+
+// Get the fraction of full speed allowed at the position (1 outside every zone, 0 in a keep out zone)
+fix16_t geofence_speed_limit(long x, long y);
+
+// Check if a straight line between the positions stays out of every keep out zone
+bool geofence_segment_allowed(long startX, long startY, long endX, long endY);
+
+// Check if any part of an index cell is in a keep out zone (the planner's cells line up with these)
+bool geofence_cell_blocked(int column, int row);
+
+#endif
\ No newline at end of file
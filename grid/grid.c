@@ -0,0 +1,224 @@
+/*
+ * grid.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "grid.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+#define GRID_CELLS (GRID_WIDTH * GRID_HEIGHT)
+#define GRID_RUN_MAX 4096 // longest run a single record can hold (12 bits)
+
+/// @brief Change the log-odds value of a cell, saturating at 0 and GRID_MAX
+/// @param index The index of the cell (row * GRID_WIDTH + column)
+/// @param change How much to add to the cell
+void adjust_cell(int index, int change);
+
+/// @brief Get the log-odds value of a cell by its index
+/// @param index The index of the cell (row * GRID_WIDTH + column)
+/// @return The log-odds value (0-15)
+uint8_t read_cell(int index);
+
+/// @brief Set the log-odds value of a cell by its index
+/// @param index The index of the cell (row * GRID_WIDTH + column)
+/// @param value The log-odds value (0-15)
+void write_cell(int index, uint8_t value);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+// two cells to a byte, the even cell in the low nibble
+uint8_t grid_cells[GRID_CELLS / 2];
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void grid_clear(void)
+{
+    memset(grid_cells, GRID_UNKNOWN | (GRID_UNKNOWN << 4), sizeof(grid_cells));
+}
+
+bool grid_cell_from_position(long x, long y, int * column, int * row)
+{
+    long offsetX = x - GRID_ORIGIN_X;
+    long offsetY = y - GRID_ORIGIN_Y;
+
+    if(offsetX < 0 || offsetY < 0)
+        return 0;
+
+    *column = offsetX / GRID_CELL_SIZE;
+    *row = offsetY / GRID_CELL_SIZE;
+    return *column < GRID_WIDTH && *row < GRID_HEIGHT;
+}
+
+void grid_position_from_cell(int column, int row, long * x, long * y)
+{
+    *x = GRID_ORIGIN_X + column * GRID_CELL_SIZE + GRID_CELL_SIZE / 2;
+    *y = GRID_ORIGIN_Y + row * GRID_CELL_SIZE + GRID_CELL_SIZE / 2;
+}
+
+uint8_t grid_get(int column, int row)
+{
+    if(column < 0 || row < 0 || column >= GRID_WIDTH || row >= GRID_HEIGHT)
+        return GRID_UNKNOWN;
+
+    return read_cell(row * GRID_WIDTH + column);
+}
+
+Grid_Cell grid_get_cell(int column, int row)
+{
+    uint8_t value = grid_get(column, row);
+
+    if(value >= GRID_OCCUPIED)
+        return Grid_Cell_Occupied;
+    if(value <= GRID_FREE)
+        return Grid_Cell_Free;
+    return Grid_Cell_Unknown;
+}
+
+void grid_update_ray(long x, long y, fix16_t angle, long range)
+{
+    // (a range of 0 is no echo, not something right at the sensor)
+    bool hit = range > 0 && range < GRID_MAX_RANGE;
+    int column, row, endColumn, endRow;
+
+    if(!hit)
+        range = GRID_MAX_RANGE;
+
+    long endX = x + FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(range), fix16_cos(angle)));
+    long endY = y + FIX16_TO_INT(fix16_mul(FIX16_FROM_INT(range), fix16_sin(angle)));
+
+    // nothing to do if the sensor itself is off the map
+    if(!grid_cell_from_position(x, y, &column, &row))
+        return;
+
+    // the end may be off the map, so work it out without the bounds check (floor the division for negative offsets)
+    long offsetX = endX - GRID_ORIGIN_X;
+    long offsetY = endY - GRID_ORIGIN_Y;
+    endColumn = offsetX >= 0 ? offsetX / GRID_CELL_SIZE : -((-offsetX + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE);
+    endRow = offsetY >= 0 ? offsetY / GRID_CELL_SIZE : -((-offsetY + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE);
+
+    // walk the cells along the ray (Bresenham)
+    int dx = abs(endColumn - column);
+    int dy = -abs(endRow - row);
+    int stepX = column < endColumn ? 1 : -1;
+    int stepY = row < endRow ? 1 : -1;
+    int error = dx + dy;
+
+    while(column != endColumn || row != endRow)
+    {
+        adjust_cell(row * GRID_WIDTH + column, -GRID_MISS);
+
+        int error2 = error * 2;
+        if(error2 >= dy)
+        {
+            error += dy;
+            column += stepX;
+        }
+        if(error2 <= dx)
+        {
+            error += dx;
+            row += stepY;
+        }
+
+        // the ray left the map before getting to the end
+        if(column < 0 || row < 0 || column >= GRID_WIDTH || row >= GRID_HEIGHT)
+            return;
+    }
+
+    adjust_cell(row * GRID_WIDTH + column, hit ? GRID_HIT : -GRID_MISS);
+}
+
+size_t grid_serialise(uint8_t * buffer, size_t size)
+{
+    size_t length = 0;
+    int index = 0;
+
+    // each record is 2 bytes: the value in the top 4 bits, then the length of the run - 1 in the remaining 12
+    while(index < GRID_CELLS)
+    {
+        uint8_t value = read_cell(index);
+        int run = 1;
+        while(index + run < GRID_CELLS && run < GRID_RUN_MAX && read_cell(index + run) == value)
+            ++run;
+
+        if(length + 2 > size)
+            return 0;
+
+        buffer[length++] = (value << 4) | ((run - 1) >> 8);
+        buffer[length++] = (run - 1) & 0xFF;
+        index += run;
+    }
+
+    return length;
+}
+
+bool grid_deserialise(const uint8_t * buffer, size_t length)
+{
+    int index = 0;
+    size_t position;
+
+    grid_clear();
+
+    for(position = 0; position + 1 < length; position += 2)
+    {
+        uint8_t value = buffer[position] >> 4;
+        int run = (((buffer[position] & 0x0F) << 8) | buffer[position + 1]) + 1;
+
+        if(index + run > GRID_CELLS)
+        {
+            grid_clear();
+            return 0;
+        }
+
+        while(run--)
+            write_cell(index++, value);
+    }
+
+    if(index != GRID_CELLS || position != length)
+    {
+        grid_clear();
+        return 0;
+    }
+
+    return 1;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+void adjust_cell(int index, int change)
+{
+    int value = read_cell(index) + change;
+
+    if(value < 0)
+        value = 0;
+    else if(value > GRID_MAX)
+        value = GRID_MAX;
+
+    write_cell(index, value);
+}
+
+uint8_t read_cell(int index)
+{
+    uint8_t cells = grid_cells[index >> 1];
+    return index & 1 ? cells >> 4 : cells & 0x0F;
+}
+
+void write_cell(int index, uint8_t value)
+{
+    uint8_t * cells = &grid_cells[index >> 1];
+    if(index & 1)
+        *cells = (*cells & 0x0F) | (value << 4);
+    else
+        *cells = (*cells & 0xF0) | value;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+/*
+ * grid.h
+ * Occupancy grid of the area the robot works in, built up from the ultrasonic returns
+ *
+ * Each cell holds a 4 bit log-odds value (two cells to a byte): 8 is unknown, every return that ends in a cell
+ * adds GRID_HIT and every return that passes through it takes away GRID_MISS, saturating at 0 (free) and 15 (occupied)
+ * At 100mm cells a 12.8m x 12.8m area (enough for a typical apartment) takes 8KB
+ *
+ * The grid serialises as runs of equal cells, so a mostly unknown/free map exports in a few hundred bytes
+ *
+ * Created: 2026-10-19
+ */
+#ifndef GRIDH
+#define GRIDH
+
+#include "pico/stdlib.h"
+#include "../fixed/fixed.h"
+
+#define GRID_CELL_SIZE  100     // mm along each side of a cell
+#define GRID_WIDTH      128     // cells along x (must be even)
+#define GRID_HEIGHT     128     // cells along y
+#define GRID_ORIGIN_X   -6400   // UWB x (in mm) of the edge of cell 0 (the grid is centred on home)
+#define GRID_ORIGIN_Y   -6400   // UWB y (in mm) of the edge of cell 0
+
+#define GRID_UNKNOWN    8       // log-odds of a cell nothing has been seen in
+#define GRID_HIT        3       // added to a cell a return ended in
+#define GRID_MISS       1       // taken away from a cell a return passed through
+#define GRID_MAX        15
+#define GRID_OCCUPIED   11      // cells at or above this are treated as occupied
+#define GRID_FREE       5       // cells at or below this are treated as free
+
+#define GRID_MAX_RANGE  2000    // mm, returns further than this (or no return) only clear the cells up to this range
+
+// Format of the serialised grid (change it whenever the format does, so old maps aren't loaded)
+#define GRID_SERIALISED_VERSION 1
+
+// Size of the buffer needed to serialise the grid in the worst case (every cell different from the one before)
+#define GRID_SERIALISED_MAX (GRID_WIDTH * GRID_HEIGHT * 2)
+
+/** \brief What is known about a cell:
+ *  \ingroup grid
+ */
+typedef enum {
+    Grid_Cell_Unknown,
+    Grid_Cell_Free,
+    Grid_Cell_Occupied
+} Grid_Cell;
+
+// Set every cell back to unknown (must be called before the grid is first used)
+void grid_clear(void);
+
+// Find the cell a position (in mm) falls in, returns 0 if it is outside of the grid
+bool grid_cell_from_position(long x, long y, int * column, int * row);
+
+// Find the position (in mm) of the centre of a cell
+void grid_position_from_cell(int column, int row, long * x, long * y);
+
+// Get the log-odds value of a cell (cells outside of the grid are unknown)
+uint8_t grid_get(int column, int row);
+
+// Get what is known about a cell
+Grid_Cell grid_get_cell(int column, int row);
+
+// Mark the cells along a ray from a position (in mm) at an angle (in rad, counter-clockwise from the x axis)
+// as free up to the range (in mm), and the cell at the end as occupied if something was hit there
+// (a range of 0, or of GRID_MAX_RANGE or more, is no return and only clears)
+void grid_update_ray(long x, long y, fix16_t angle, long range);
+
+// Serialise the grid into the buffer, returns the number of bytes used (0 if the buffer was too small)
+size_t grid_serialise(uint8_t * buffer, size_t size);
+
+// Replace the grid with one that was serialised, returns 0 (leaving the grid cleared) if the data doesn't cover the grid exactly
+bool grid_deserialise(const uint8_t * buffer, size_t length);
+
+#endif
\ No newline at end of file
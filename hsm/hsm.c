@@ -0,0 +1,264 @@
+/*
+ * hsm.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hsm.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+/// @brief Check if a state is another state or one of its parents
+/// @param hsm The state machine
+/// @param ancestor The state that may be the parent
+/// @param state The state to check from
+/// @return 1 if ancestor is state or one of its parents
+bool is_ancestor(struct Hsm * hsm, int8_t ancestor, int8_t state);
+
+/// @brief Enter a state (starting its timer and running its entry action)
+/// @param hsm The state machine
+/// @param state The state
+void enter_state(struct Hsm * hsm, int8_t state);
+
+/// @brief Leave the current state for the target of a transition, running the exit, transition and entry actions
+/// @param hsm The state machine
+/// @param index The index of the transition
+/// @param event The event that caused it (for the log)
+void take_transition(struct Hsm * hsm, int index, uint8_t event);
+
+/// @brief Add a transition to the log
+/// @param hsm The state machine
+/// @param from The state it was in
+/// @param to The state it is in now
+/// @param event The event that caused it
+void log_transition(struct Hsm * hsm, int8_t from, int8_t to, uint8_t event);
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void hsm_init(struct Hsm * hsm, const struct HsmState * states, int stateCount,
+    const struct HsmTransition * transitions, int transitionCount, int8_t initial, uint8_t timeoutEvent)
+{
+    int state, event, index;
+
+    hsm->states = states;
+    hsm->transitions = transitions;
+    hsm->stateCount = stateCount;
+    hsm->timeout_event = timeoutEvent;
+    hsm->log_count = 0;
+    hsm->log_time = time_us_64();
+
+    // flatten the transitions: each state takes its own, or else the nearest parent's
+    for(state = 0; state < stateCount; ++state)
+    {
+        hsm->last_child[state] = HSM_NONE;
+        for(event = 0; event < HSM_MAX_EVENTS; ++event)
+        {
+            int8_t handler = state;
+            hsm->table[state][event] = HSM_NONE;
+
+            while(handler != HSM_NONE && hsm->table[state][event] == HSM_NONE)
+            {
+                for(index = 0; index < transitionCount; ++index)
+                {
+                    if(transitions[index].state == handler && transitions[index].event == event)
+                    {
+                        hsm->table[state][event] = index;
+                        break;
+                    }
+                }
+                handler = states[handler].parent;
+            }
+        }
+    }
+
+    // enter the initial state through its parents, then down through its initial children
+    int8_t path[HSM_MAX_DEPTH];
+    int depth = 0;
+    for(state = initial; state != HSM_NONE && depth < HSM_MAX_DEPTH; state = states[state].parent)
+        path[depth++] = state;
+    while(depth > 0)
+        enter_state(hsm, path[--depth]);
+
+    hsm->current = initial;
+    while(states[hsm->current].initial != HSM_NONE)
+    {
+        hsm->current = states[hsm->current].initial;
+        enter_state(hsm, hsm->current);
+    }
+}
+
+bool hsm_dispatch(struct Hsm * hsm, uint8_t event)
+{
+    if(event >= HSM_MAX_EVENTS)
+        return 0;
+
+    int index = hsm->table[hsm->current][event];
+    if(index == HSM_NONE)
+        return 0;
+
+    take_transition(hsm, index, event);
+    return 1;
+}
+
+void hsm_step(struct Hsm * hsm)
+{
+    uint64_t now = time_us_64();
+    int8_t state;
+
+    // innermost timer first
+    for(state = hsm->current; state != HSM_NONE; state = hsm->states[state].parent)
+    {
+        const long * timeout = hsm->states[state].timeout;
+        if(timeout == NULL || now - hsm->entered[state] < (uint64_t) *timeout)
+            continue;
+
+        // start it again either way, so an unhandled timeout comes round once per period rather than every step
+        hsm->entered[state] = now;
+
+        int index = hsm->table[state][hsm->timeout_event];
+        if(index != HSM_NONE)
+        {
+            take_transition(hsm, index, hsm->timeout_event);
+            return;
+        }
+    }
+
+    HsmAction during = hsm->states[hsm->current].during;
+    if(during != NULL)
+        during();
+}
+
+int8_t hsm_current(struct Hsm * hsm)
+{
+    return hsm->current;
+}
+
+bool hsm_in_state(struct Hsm * hsm, int8_t state)
+{
+    return is_ancestor(hsm, state, hsm->current);
+}
+
+void hsm_reset_timer(struct Hsm * hsm, int8_t state)
+{
+    hsm->entered[state] = time_us_64();
+}
+
+int hsm_copy_log(struct Hsm * hsm, uint32_t * buffer, int length)
+{
+    int count = hsm->log_count < HSM_LOG_LENGTH ? hsm->log_count : HSM_LOG_LENGTH;
+    int index;
+
+    if(count > length)
+        count = length;
+
+    // the newest count entries, oldest first
+    for(index = 0; index < count; ++index)
+        buffer[index] = hsm->log[(hsm->log_count - count + index) % HSM_LOG_LENGTH];
+
+    return count;
+}
+
+void hsm_print_log(struct Hsm * hsm, int length)
+{
+    uint32_t entries[HSM_LOG_LENGTH];
+    int count = hsm_copy_log(hsm, entries, length < HSM_LOG_LENGTH ? length : HSM_LOG_LENGTH);
+    int index;
+
+    for(index = 0; index < count; ++index)
+    {
+        int from = (entries[index] >> 11) & 0x1F;
+        int to = (entries[index] >> 6) & 0x1F;
+        // (a state that doesn't fit in the table was none, i.e. the initial transition)
+        printf("\ntransition after %d ms: %s -> %s (event %d)", (int) (entries[index] >> 16),
+            from < hsm->stateCount ? hsm->states[from].name : "none",
+            to < hsm->stateCount ? hsm->states[to].name : "none", (int) (entries[index] & 0x3F));
+    }
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+bool is_ancestor(struct Hsm * hsm, int8_t ancestor, int8_t state)
+{
+    for(; state != HSM_NONE; state = hsm->states[state].parent)
+    {
+        if(state == ancestor)
+            return 1;
+    }
+    return 0;
+}
+
+void enter_state(struct Hsm * hsm, int8_t state)
+{
+    hsm->entered[state] = time_us_64();
+    if(hsm->states[state].entry != NULL)
+        hsm->states[state].entry();
+}
+
+void take_transition(struct Hsm * hsm, int index, uint8_t event)
+{
+    const struct HsmTransition * transition = &hsm->transitions[index];
+    const struct HsmState * states = hsm->states;
+    int8_t from = hsm->current;
+    int8_t target = transition->target;
+    int8_t state;
+
+    // the innermost state that stays active (the target itself is always left and entered again)
+    int8_t common = states[target].parent;
+    while(common != HSM_NONE && !is_ancestor(hsm, common, from))
+        common = states[common].parent;
+
+    // leave everything up to there, remembering where each parent was up to
+    for(state = from; state != common; state = states[state].parent)
+    {
+        if(states[state].exit != NULL)
+            states[state].exit();
+        if(states[state].parent != HSM_NONE)
+            hsm->last_child[states[state].parent] = state;
+    }
+
+    if(transition->action != NULL)
+        transition->action();
+
+    // enter back down to the target
+    int8_t path[HSM_MAX_DEPTH];
+    int depth = 0;
+    for(state = target; state != common && depth < HSM_MAX_DEPTH; state = states[state].parent)
+        path[depth++] = state;
+    while(depth > 0)
+        enter_state(hsm, path[--depth]);
+
+    // and on into its children
+    state = target;
+    while(states[state].initial != HSM_NONE)
+    {
+        if(transition->history && hsm->last_child[state] != HSM_NONE)
+            state = hsm->last_child[state];
+        else
+            state = states[state].initial;
+        enter_state(hsm, state);
+    }
+
+    hsm->current = state;
+    log_transition(hsm, from, state, event);
+    printf("\nstate: %s -> %s", states[from].name, states[state].name);
+}
+
+void log_transition(struct Hsm * hsm, int8_t from, int8_t to, uint8_t event)
+{
+    uint64_t now = time_us_64();
+    uint32_t elapsed = (now - hsm->log_time) / 1000;
+
+    if(elapsed > 0xFFFF)
+        elapsed = 0xFFFF;
+
+    hsm->log[hsm->log_count % HSM_LOG_LENGTH] = (elapsed << 16) | ((from & 0x1F) << 11) | ((to & 0x1F) << 6) | (event & 0x3F);
+    ++hsm->log_count;
+    hsm->log_time = now;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+/*
+ * hsm.h
+ * Table driven hierarchical state machine
+ *
+ * States are described by a table (parent, initial child, timeout, entry/exit/during actions) and the transitions
+ * by a list of (state, event ==> target, action). A transition listed for a parent state applies to all of its children
+ * unless a child lists its own. hsm_init flattens the inherited transitions into a state x event table, so
+ * dispatching an event is a single table lookup
+ *
+ * Every state has its own timer, started when it is entered: once it has been in the state for the timeout
+ * the timeout event is dispatched as if from that state
+ *
+ * Each transition is logged into a ring as a single 32 bit word:
+ *   ---------------------------------------------------------------------
+ *   |   b31-b16 (ms since the last transition)   | b15-b11 | b10-b6 | b5-b0 |
+ *   ---------------------------------------------------------------------
+ *   |          saturates at 65535                |  from   |   to   | event |
+ *   ---------------------------------------------------------------------
+ *
+ * Created: 2026-10-19
+ */
+#ifndef HSMH
+#define HSMH
+
+#include "pico/stdlib.h"
+
+#define HSM_MAX_STATES  32  // fits the 5 bits in the log
+#define HSM_MAX_EVENTS  16  // (the log has room for 64)
+#define HSM_MAX_DEPTH   4   // most levels of nesting
+#define HSM_LOG_LENGTH  64  // transitions kept in the log
+#define HSM_NONE        -1
+
+typedef void (*HsmAction)(void);
+
+struct HsmState {
+    const char * name;
+    int8_t parent;          // HSM_NONE at the top level
+    int8_t initial;         // child to enter when this state is the target (HSM_NONE if it has no children)
+    const long * timeout;   // us in the state before its timeout event (NULL for none)
+    HsmAction entry;        // (any of the actions can be NULL)
+    HsmAction exit;
+    HsmAction during;       // run every step while this is the current (innermost) state
+};
+
+struct HsmTransition {
+    int8_t state;           // state (or parent of states) the event is handled in
+    int8_t event;
+    int8_t target;
+    bool history;           // go back to whichever child of the target was last active, rather than its initial child
+    HsmAction action;       // run between leaving the old states and entering the new ones (can be NULL)
+};
+
+struct Hsm {
+    const struct HsmState * states;
+    const struct HsmTransition * transitions;
+    int stateCount;
+    int8_t table[HSM_MAX_STATES][HSM_MAX_EVENTS];   // index of the transition each state takes for each event
+    int8_t current;                                 // innermost active state
+    int8_t last_child[HSM_MAX_STATES];              // last active child of each state, for history
+    uint64_t entered[HSM_MAX_STATES];               // us, when each state was entered (or its timer was reset)
+    uint8_t timeout_event;
+    uint32_t log[HSM_LOG_LENGTH];
+    uint32_t log_count;                             // transitions logged in all
+    uint64_t log_time;                              // us, when the last transition was logged
+};
+
+// Set up the state machine from its tables and enter the initial state
+void hsm_init(struct Hsm * hsm, const struct HsmState * states, int stateCount,
+    const struct HsmTransition * transitions, int transitionCount, int8_t initial, uint8_t timeoutEvent);
+
+// Dispatch an event to the current state, returns 0 if nothing handles it
+bool hsm_dispatch(struct Hsm * hsm, uint8_t event);
+
+// Dispatch any timeouts that are due, then run the during action of the current state
+void hsm_step(struct Hsm * hsm);
+
+// Get the innermost active state
+int8_t hsm_current(struct Hsm * hsm);
+
+// Check if a state is active (it's the current state or one of its parents)
+bool hsm_in_state(struct Hsm * hsm, int8_t state);
+
+// Start a state's timer again
+void hsm_reset_timer(struct Hsm * hsm, int8_t state);
+
+// Copy the log (oldest first) into the buffer, returns the number of entries copied
+int hsm_copy_log(struct Hsm * hsm, uint32_t * buffer, int length);
+
+// Print up to the given number of the latest transitions from the log (oldest first), with the states' names
+void hsm_print_log(struct Hsm * hsm, int length);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,364 @@
+/*
+ * ingest.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "../ipc/ipc.h"
+#include "../scheduler/scheduler.h"
+#include "../web/web.h"
+#include "ingest.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+// Entry point of core 1
+void core1_main(void);
+
+// Run any commands queued by core 0
+void handle_commands(void);
+
+// Publish the sensor values if a new frame has come in from the atmega
+void publish_sensor_values(void);
+
+// Poll the DWM1001 for the robot's position and publish it when one is read (run by the scheduler)
+void publish_robot_position(void * data);
+
+// Start the wifi connecting, then keep it connected (run by the scheduler)
+void poll_wifi(void * data);
+
+// Record when a subsystem came up, if it hasn't already
+void mark_ready(uint64_t * ready);
+
+// Publish the results of any web requests that have finished
+void publish_web_responses(void);
+
+// Log the oldest delivery that the server hasn't logged yet, and move on to the next once it has
+void log_deliveries(void);
+
+// Take the oldest delivery off the ones waiting to be logged
+void drop_log(void);
+
+// Check if there's a snapshot newer than the last one taken, and copy it out if there is
+bool take_snapshot(struct IpcSnapshot * snapshot, uint32_t * taken, void * value);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+// Wifi details for core 1 to connect with
+const char * wifi_ssid;
+const char * wifi_pass;
+const char * wifi_hostname;
+
+// Commands from core 0 to core 1
+struct IpcQueue commands;
+
+// Storage for the values published by core 1
+struct AtmegaSensorValues sensor_values;
+struct DWM1001_Position robot_position;
+struct DWM1001_Position user_position;
+struct IngestStatus ingest_status;
+struct GeofenceZones server_zones;
+struct IngestDeliveries deliveries;
+
+struct IpcSnapshot sensor_snapshot = IPC_SNAPSHOT(sensor_values);
+struct IpcSnapshot robot_snapshot = IPC_SNAPSHOT(robot_position);
+struct IpcSnapshot user_snapshot = IPC_SNAPSHOT(user_position);
+struct IpcSnapshot status_snapshot = IPC_SNAPSHOT(ingest_status);
+struct IpcSnapshot zones_snapshot = IPC_SNAPSHOT(server_zones);
+struct IpcSnapshot deliveries_snapshot = IPC_SNAPSHOT(deliveries);
+
+// How many of each snapshot core 0 has already taken
+uint32_t sensor_taken = 0;
+uint32_t robot_taken = 0;
+uint32_t user_taken = 0;
+uint32_t zones_taken = 0;
+uint32_t deliveries_taken = 0;
+
+// Core 1 only: web requests that have been made but whose results haven't been published
+bool user_location_pending = 0;
+bool zones_pending = 0;
+bool deliveries_pending = 0;
+
+// Core 1 only: schedule ids of the deliveries the server hasn't logged yet (oldest first), and when to next try
+int logs[INGEST_MAX_LOGS];
+int log_count = 0;
+uint64_t log_retry_time = 0;
+
+// Core 1 only: periodic work, the last frame published, whether the wifi has been started (-1 if it failed)
+// and when each subsystem came up
+struct Scheduler ingest_scheduler;
+uint32_t last_frame = 0;
+int wifi_started = 0;
+struct IngestStatus status;
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void ingest_launch(const char *ssid, const char *pass, const char *hostname)
+{
+    wifi_ssid = ssid;
+    wifi_pass = pass;
+    wifi_hostname = hostname;
+    multicore_launch_core1(core1_main);
+}
+
+bool ingest_request(Ingest_Command command, int argument)
+{
+    return ipc_queue_push(&commands, ((uint32_t) command << 24) | (argument & 0xFFFFFF));
+}
+
+struct AtmegaSensorValues ingest_get_sensor_values(void)
+{
+    struct AtmegaSensorValues values;
+    (void) ipc_snapshot_read(&sensor_snapshot, &values);
+    return values;
+}
+
+struct IngestStatus ingest_get_status(void)
+{
+    struct IngestStatus value;
+    (void) ipc_snapshot_read(&status_snapshot, &value);
+    return value;
+}
+
+bool ingest_take_sensor_values(struct AtmegaSensorValues * values)
+{
+    return take_snapshot(&sensor_snapshot, &sensor_taken, values);
+}
+
+bool ingest_take_robot_position(struct DWM1001_Position * position)
+{
+    return take_snapshot(&robot_snapshot, &robot_taken, position);
+}
+
+bool ingest_take_user_position(struct DWM1001_Position * position)
+{
+    return take_snapshot(&user_snapshot, &user_taken, position);
+}
+
+bool ingest_take_zones(struct GeofenceZones * zones)
+{
+    return take_snapshot(&zones_snapshot, &zones_taken, zones);
+}
+
+bool ingest_take_deliveries(struct IngestDeliveries * deliveries)
+{
+    return take_snapshot(&deliveries_snapshot, &deliveries_taken, deliveries);
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+void core1_main(void)
+{
+    // let core 0 pause us while it writes to flash (see store)
+    multicore_lockout_victim_init();
+
+    // the UART interrupts are enabled on whichever core sets them up, so do it here to keep them off core 0
+    dwm1001_init_communication();
+    atmega_init_communication();
+
+    // the wifi comes up alongside everything else rather than holding it up
+    scheduler_init(&ingest_scheduler);
+    scheduler_add(&ingest_scheduler, "uwb", time_us_64(), INGEST_ROBOT_REQUEST_DURATION, publish_robot_position, NULL);
+    scheduler_add(&ingest_scheduler, "wifi", time_us_64(), INGEST_WIFI_POLL_DURATION, poll_wifi, NULL);
+
+    while(true)
+    {
+        handle_commands();
+        publish_sensor_values();
+        scheduler_run(&ingest_scheduler);
+        publish_web_responses();
+        log_deliveries();
+    }
+}
+
+void handle_commands(void)
+{
+    uint32_t item;
+    struct DWM1001_Position position;
+
+    while(ipc_queue_pop(&commands, &item))
+    {
+        Ingest_Command command = item >> 24;
+        // sign extend the 24 bit argument back out (so -1 survives the trip)
+        int argument = ((int32_t) (item << 8)) >> 8;
+
+        switch(command)
+        {
+            case Ingest_Command_LogDelivery:
+                // (made by log_deliveries, so a request that fails or can't be made yet isn't lost)
+                if(log_count == INGEST_MAX_LOGS)
+                {
+                    printf("\ntoo many deliveries to log, dropping %d", logs[0]);
+                    drop_log();
+                }
+                logs[log_count++] = argument;
+                break;
+            case Ingest_Command_GetUserLocation:
+                web_request_get_user_location();
+                user_location_pending = 1;
+                break;
+            case Ingest_Command_GetZones:
+                web_request_get_zones();
+                zones_pending = 1;
+                break;
+            case Ingest_Command_GetDeliveries:
+                web_request_get_deliveries();
+                deliveries_pending = 1;
+                break;
+            case Ingest_Command_ReportStuck:
+                (void) ipc_snapshot_read(&robot_snapshot, &position);
+                web_request_report_stuck(argument, position.x, position.y);
+                break;
+        }
+    }
+}
+
+void publish_sensor_values(void)
+{
+    uint32_t frame = atmega_frames_received();
+    if(frame != last_frame)
+    {
+        struct AtmegaSensorValues values = atmega_retrieve_sensor_values();
+        last_frame = frame;
+        ipc_snapshot_publish(&sensor_snapshot, &values);
+        mark_ready(&status.sensors_us);
+    }
+}
+
+void publish_robot_position(void * data)
+{
+    // (sends the request, then reads whatever of the response has come in each time, so a missing module never holds up
+    // the rest of core 1, it just never comes up)
+    struct DWM1001_Position position = dwm1001_request_position();
+    if(position.set)
+    {
+        ipc_snapshot_publish(&robot_snapshot, &position);
+        mark_ready(&status.uwb_us);
+    }
+}
+
+void poll_wifi(void * data)
+{
+    if(wifi_started == 0)
+    {
+        // (loading the wifi chip's firmware still takes a moment, but the connecting doesn't wait)
+        // (only the chip failing to start is fatal, web_poll tries connecting again itself)
+        int result = web_init(wifi_ssid, wifi_pass, wifi_hostname, NULL, NULL, NULL);
+        wifi_started = result == 1 ? -1 : 1;
+        if(result != 0)
+            printf("\nwifi failed to start: %d", result);
+    }
+
+    if(wifi_started == 1 && web_poll() && status.wifi_us == 0)
+    {
+        mark_ready(&status.wifi_us);
+        // the zones may have changed while the robot was off
+        web_request_get_zones();
+        zones_pending = 1;
+    }
+}
+
+void mark_ready(uint64_t * ready)
+{
+    if(*ready == 0)
+    {
+        *ready = time_us_64();
+        ipc_snapshot_publish(&status_snapshot, &status);
+    }
+}
+
+void publish_web_responses(void)
+{
+    if(deliveries_pending)
+    {
+        struct IngestDeliveries received;
+        received.received = web_response_get_deliveries(&received.tour, &received.next_due);
+        // a failed request is published too, so core 0 knows to ask again
+        if(received.received || !web_request_active(Web_RequestType_GetDeliveries))
+        {
+            if(!received.received)
+            {
+                received.tour.count = 0;
+                received.next_due = -1;
+            }
+            deliveries_pending = 0;
+            ipc_snapshot_publish(&deliveries_snapshot, &received);
+        }
+    }
+
+    if(zones_pending)
+    {
+        // (static, it's too big to be put on the stack every time round)
+        static struct GeofenceZones received;
+        if(web_response_get_zones(&received))
+        {
+            zones_pending = 0;
+            ipc_snapshot_publish(&zones_snapshot, &received);
+        }
+        else if(!web_request_active(Web_RequestType_GetZones))
+        {
+            zones_pending = 0;
+        }
+    }
+
+    if(user_location_pending)
+    {
+        struct DWM1001_Position position = web_response_get_user_location();
+        if(position.set)
+        {
+            user_location_pending = 0;
+            ipc_snapshot_publish(&user_snapshot, &position);
+        }
+        else if(!web_request_active(Web_RequestType_GetUserLocation))
+        {
+            // the request failed, let core 0 ask again
+            user_location_pending = 0;
+        }
+    }
+}
+
+void log_deliveries(void)
+{
+    if(log_count == 0)
+        return;
+
+    if(web_response_log_delivery())
+    {
+        // the server has it, the next can go straight away
+        drop_log();
+        log_retry_time = 0;
+    }
+    else if(!web_request_active(Web_RequestType_LogDelivery) && time_us_64() >= log_retry_time)
+    {
+        // not tried yet, or the last try failed (or there was no connection to make it on)
+        log_retry_time = time_us_64() + INGEST_LOG_RETRY_DURATION;
+        web_request_log_delivery(logs[0]);
+    }
+}
+
+void drop_log(void)
+{
+    int log;
+    --log_count;
+    for(log = 0; log < log_count; ++log)
+        logs[log] = logs[log + 1];
+}
+
+bool take_snapshot(struct IpcSnapshot * snapshot, uint32_t * taken, void * value)
+{
+    // (checked before copying, the value is left alone when there's nothing new)
+    if(ipc_snapshot_sequence(snapshot) == *taken)
+        return 0;
+
+    *taken = ipc_snapshot_read(snapshot, value);
+    return 1;
+}
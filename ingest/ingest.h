@@ -0,0 +1,79 @@
+/*
+ * ingest.h
+ * Sensor, positioning and network work that runs on core 1
+ *
+ * Core 1 owns the atmega UART (and its interrupt), the DWM1001 UART and the web client.
+ * It publishes the latest sensor values, robot position, user position, zones and due deliveries as snapshots,
+ * and core 0 (the control loop) reads them without ever waiting on a UART or the network
+ * Requests for core 1 to talk to the server are passed through a command queue
+ *
+ * Created: 2026-10-19
+ */
+#ifndef INGESTH
+#define INGESTH
+
+#include "pico/stdlib.h"
+#include "../atmega/atmega.h"
+#include "../dwm1001/dwm1001.h"
+#include "../geofence/geofence.h"
+#include "../tour/tour.h"
+
+#define INGEST_ROBOT_REQUEST_DURATION 20000 // 20ms (in us) (the robot only updates every 100ms but we want to ensure we get the new value fairly accurately)
+#define INGEST_WIFI_POLL_DURATION     50000 // 50ms (in us) between checks on the wifi connection
+#define INGEST_LOG_RETRY_DURATION     5000000 // 5s (in us) before trying to log a delivery again after it failed
+#define INGEST_MAX_LOGS               TOUR_MAX_STOPS // deliveries that can be waiting to be logged (a whole tour's worth)
+
+/** \brief Commands core 0 can queue for core 1:
+ *  \ingroup ingest
+ */
+typedef enum {
+    Ingest_Command_LogDelivery,     // (kept and tried again until the server has it)
+    Ingest_Command_GetUserLocation,
+    Ingest_Command_ReportStuck,     // (the argument is the schedule id, the robot's last position is added by core 1)
+    Ingest_Command_GetZones,        // (also asked for by core 1 itself once the wifi first connects)
+    Ingest_Command_GetDeliveries
+} Ingest_Command;
+
+// The result of asking the server for the deliveries that are due
+struct IngestDeliveries {
+    bool received;          // 0 if the request failed
+    long next_due;          // s until the next delivery comes due, if the server said (-1 if not)
+    struct Tour tour;       // a stop for each delivery that's due
+};
+
+// When each of core 1's subsystems first came up (us since boot, 0 until then)
+struct IngestStatus {
+    uint64_t sensors_us;    // first frame received from the atmega
+    uint64_t uwb_us;        // first position read from the DWM1001
+    uint64_t wifi_us;       // connected to the network
+};
+
+// Start core 1 running the ingestion loop, which will connect to the wifi network itself (in the background, so the
+// sensors and UWB are published straight away)
+void ingest_launch(const char *ssid, const char *pass, const char *hostname);
+
+// Queue a command for core 1 (the argument is limited to 24 bits), returns 0 if the queue was full
+bool ingest_request(Ingest_Command command, int argument);
+
+// Get the latest sensor values received from the atmega
+struct AtmegaSensorValues ingest_get_sensor_values(void);
+
+// Get which of core 1's subsystems are up, and when they came up
+struct IngestStatus ingest_get_status(void);
+
+// Check for sensor values that haven't been taken yet (i.e. a new frame), returns 1 and fills in the values if there are some
+bool ingest_take_sensor_values(struct AtmegaSensorValues * values);
+
+// Check for a robot position from the DWM1001 that hasn't been taken yet, returns 1 and fills in the position if there is one
+bool ingest_take_robot_position(struct DWM1001_Position * position);
+
+// Check for a user position from the server that hasn't been taken yet, returns 1 and fills in the position if there is one
+bool ingest_take_user_position(struct DWM1001_Position * position);
+
+// Check for zones from the server that haven't been taken yet, returns 1 and fills in the zones if there are some
+bool ingest_take_zones(struct GeofenceZones * zones);
+
+// Check for a deliveries result that hasn't been taken yet, returns 1 and fills in the result if there is one
+bool ingest_take_deliveries(struct IngestDeliveries * deliveries);
+
+#endif
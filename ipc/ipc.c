@@ -0,0 +1,76 @@
+/*
+ * ipc.c
+ *
+ * Created: 2026-10-19
+ */
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "ipc.h"
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void ipc_snapshot_publish(struct IpcSnapshot * snapshot, const void * value)
+{
+    // mark the write as in progress before touching the data, and only mark it done once all of it is written
+    ++snapshot->sequence;
+    __dmb();
+    memcpy(snapshot->data, value, snapshot->size);
+    __dmb();
+    ++snapshot->sequence;
+}
+
+uint32_t ipc_snapshot_read(struct IpcSnapshot * snapshot, void * value)
+{
+    uint32_t before;
+    uint32_t after;
+
+    do
+    {
+        before = snapshot->sequence;
+        __dmb();
+        memcpy(value, snapshot->data, snapshot->size);
+        __dmb();
+        after = snapshot->sequence;
+    // a write was in progress or happened while we copied, so the copy may be torn
+    } while((before & 1) || before != after);
+
+    return after / 2;
+}
+
+uint32_t ipc_snapshot_sequence(struct IpcSnapshot * snapshot)
+{
+    // (a write still in progress hasn't been published yet)
+    return snapshot->sequence / 2;
+}
+
+bool ipc_queue_push(struct IpcQueue * queue, uint32_t item)
+{
+    uint32_t head = queue->head;
+
+    if(head - queue->tail == IPC_QUEUE_LENGTH)
+        return 0;
+
+    queue->items[head & (IPC_QUEUE_LENGTH - 1)] = item;
+    // the item has to be in place before the consumer can see the new head
+    __dmb();
+    queue->head = head + 1;
+    return 1;
+}
+
+bool ipc_queue_pop(struct IpcQueue * queue, uint32_t * item)
+{
+    uint32_t tail = queue->tail;
+
+    if(queue->head == tail)
+        return 0;
+
+    __dmb();
+    *item = queue->items[tail & (IPC_QUEUE_LENGTH - 1)];
+    __dmb();
+    // only free the slot once we're done reading it
+    queue->tail = tail + 1;
+    return 1;
+}
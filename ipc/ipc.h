@@ -0,0 +1,50 @@
+/*
+ * ipc.h
+ * Lock-free sharing of data between the two cores
+ *
+ * Snapshots: a single writer publishes the latest copy of a value, readers always get a complete copy
+ * (a sequence count is odd while a write is in progress, readers retry if it changed while they copied)
+ * Queues: a single producer/single consumer ring of 32 bit commands
+ *
+ * The multicore FIFO is left alone since the SDK uses it to pause the other core while writing flash
+ *
+ * Created: 2026-10-19
+ */
+#ifndef IPCH
+#define IPCH
+
+#include "pico/stdlib.h"
+
+#define IPC_QUEUE_LENGTH 16 // must be a power of 2
+
+struct IpcSnapshot {
+    volatile uint32_t sequence; // odd while a write is in progress, increased by 2 for every publish
+    void * data;                // storage for the value being shared
+    size_t size;                // size of the value being shared
+};
+
+// Declare the snapshot for the storage (e.g. struct IpcSnapshot x = IPC_SNAPSHOT(storage);)
+#define IPC_SNAPSHOT(storage) { 0, &(storage), sizeof(storage) }
+
+struct IpcQueue {
+    volatile uint32_t head;     // next slot to write (only changed by the producer)
+    volatile uint32_t tail;     // next slot to read (only changed by the consumer)
+    volatile uint32_t items[IPC_QUEUE_LENGTH];
+};
+
+// Publish a new copy of the value to the snapshot (only one core may publish to a snapshot)
+void ipc_snapshot_publish(struct IpcSnapshot * snapshot, const void * value);
+
+// Copy the latest value out of the snapshot, returns how many times it has been published (0 if never)
+uint32_t ipc_snapshot_read(struct IpcSnapshot * snapshot, void * value);
+
+// Get how many times the snapshot has been published (0 if never) without copying the value out
+uint32_t ipc_snapshot_sequence(struct IpcSnapshot * snapshot);
+
+// Add an item to the queue, returns 0 if the queue is full
+bool ipc_queue_push(struct IpcQueue * queue, uint32_t item);
+
+// Take the oldest item from the queue, returns 0 if the queue is empty
+bool ipc_queue_pop(struct IpcQueue * queue, uint32_t * item);
+
+#endif
@@ -6,6 +6,12 @@
  * Created: 2023-03-14
  * Author: Kia Skretteberg
  */ 
+#ifndef IRH
+#define IRH
+
+// Where the sensors look down at the floor, in degrees counter-clockwise from straight ahead (both are at the front corners)
+#define IR_L_ANGLE 25
+#define IR_R_ANGLE -25
 
 typedef enum
 {
@@ -15,3 +21,5 @@ typedef enum
 
 // Checks if the sensor no longer detects ground beneath it (1 if no ground ==> drop, 0 if ground ==> no drop)
 bool IR_CheckForDrop(char distance, char expectedDistance);
+
+#endif
\ No newline at end of file
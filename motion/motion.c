@@ -0,0 +1,142 @@
+/*
+ * motion.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "motion.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+/// @brief Retire whatever primitive is running so its alarm can't end the new one (must come before the motors are commanded)
+/// @param primitive The primitive being started
+void replace_primitive(Motion_Primitive primitive);
+
+/// @brief Start the alarm that will end the current primitive
+/// @param duration_ms How long the primitive should run before it is ended
+void start_primitive(uint32_t duration_ms);
+
+/// @brief Alarm callback fired when the running primitive's time is up
+/// @param id The id of the alarm that fired
+/// @param user_data The generation of the primitive the alarm was started for
+/// @return 0 so the alarm is not rescheduled
+int64_t end_primitive(alarm_id_t id, void *user_data);
+
+/// @brief Stop all the drive motors
+void stop_motors(void);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+// The primitive currently running, set back to none by the alarm when it finishes
+volatile Motion_Primitive current_primitive = Motion_Primitive_None;
+
+// The alarm that will end the current primitive (0 if no alarm is pending)
+volatile alarm_id_t primitive_alarm = 0;
+
+// Incremented every time a primitive starts so an alarm left over from an older one is ignored
+volatile uint32_t primitive_generation = 0;
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void motion_start_drive(MotorDirection dir, fix16_t speed, uint32_t duration_ms)
+{
+    replace_primitive(Motion_Primitive_Drive);
+    if(dir == Motor_Reverse)
+        motor_set_differential(-speed, -speed);
+    else
+        motor_set_differential(speed, speed);
+    start_primitive(duration_ms);
+}
+
+void motion_start_turn(Motion_TurnDirection dir, fix16_t speed, uint32_t duration_ms)
+{
+    replace_primitive(Motion_Primitive_Turn);
+    if(dir == Motion_Turn_Right)
+        motor_set_differential(speed, -speed);
+    else
+        motor_set_differential(-speed, speed);
+    start_primitive(duration_ms);
+}
+
+void motion_start_stop_settle(uint32_t settle_ms)
+{
+    replace_primitive(Motion_Primitive_StopSettle);
+    stop_motors();
+    start_primitive(settle_ms);
+}
+
+bool motion_is_done(void)
+{
+    return current_primitive == Motion_Primitive_None;
+}
+
+Motion_Primitive motion_current(void)
+{
+    return current_primitive;
+}
+
+void motion_cancel(void)
+{
+    if(primitive_alarm)
+    {
+        cancel_alarm(primitive_alarm);
+        primitive_alarm = 0;
+    }
+    stop_motors();
+    current_primitive = Motion_Primitive_None;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+void replace_primitive(Motion_Primitive primitive)
+{
+    // a new primitive replaces whatever was running, so make sure the old alarm can't end it early
+    // (an old alarm that fires before this only stops the motors before they're commanded again)
+    if(primitive_alarm)
+        cancel_alarm(primitive_alarm);
+    primitive_alarm = 0;
+
+    ++primitive_generation;
+    current_primitive = primitive;
+}
+
+void start_primitive(uint32_t duration_ms)
+{
+    alarm_id_t alarm = add_alarm_in_ms(duration_ms, end_primitive, (void *) (uintptr_t) primitive_generation, true);
+
+    // no alarm slots were free, don't leave the motors running with nothing to stop them
+    if(alarm < 0)
+    {
+        alarm = 0;
+        stop_motors();
+        current_primitive = Motion_Primitive_None;
+    }
+    // (0 means the alarm already fired and ended the primitive)
+    primitive_alarm = alarm;
+}
+
+int64_t end_primitive(alarm_id_t id, void *user_data)
+{
+    // ignore an alarm that was superseded by a newer primitive
+    if((uint32_t) (uintptr_t) user_data == primitive_generation)
+    {
+        stop_motors();
+        primitive_alarm = 0;
+        current_primitive = Motion_Primitive_None;
+    }
+    return 0;
+}
+
+void stop_motors(void)
+{
+    motor_stop_all();
+}
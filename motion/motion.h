@@ -0,0 +1,50 @@
+/*
+ * motion.h
+ * Timed motion primitives (drive, turn, stop and settle) that run in the background
+ * Each primitive is ended by a hardware alarm, so the main loop can start one, 
+ * keep checking the sensors, and poll for when it has finished
+ *
+ * Created: 2026-10-19
+ */
+#ifndef MOTIONH
+#define MOTIONH
+
+#include "../motors/motors.h"
+
+/** \brief Selector for the primitive currently running:
+ *  \ingroup motion
+ */
+typedef enum {
+    Motion_Primitive_None,
+    Motion_Primitive_Drive,
+    Motion_Primitive_Turn,
+    Motion_Primitive_StopSettle
+} Motion_Primitive;
+
+/** \brief Selector for which way to turn on the spot:
+ *  \ingroup motion
+ */
+typedef enum {
+    Motion_Turn_Right,
+    Motion_Turn_Left
+} Motion_TurnDirection;
+
+// Drive all the motors in the direction at the speed (cm/s, fixed point) for the duration, then stop
+void motion_start_drive(MotorDirection dir, fix16_t speed, uint32_t duration_ms);
+
+// Spin on the spot in the direction at the speed (cm/s, fixed point) for the duration, then stop
+void motion_start_turn(Motion_TurnDirection dir, fix16_t speed, uint32_t duration_ms);
+
+// Stop all the motors and wait the duration for the robot to come to rest
+void motion_start_stop_settle(uint32_t settle_ms);
+
+// Check if the last primitive started has finished (or none was ever started)
+bool motion_is_done(void);
+
+// Check which primitive is currently running (Motion_Primitive_None if done)
+Motion_Primitive motion_current(void);
+
+// Abort the running primitive, stopping the motors immediately
+void motion_cancel(void);
+
+#endif
@@ -6,44 +6,134 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
 #include "hardware/pwm.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
 #include "motors.h"
-#include "math.h"
+#include "../store/store.h"
 
 /************************************************************************/
 /* Local Definitions (private functions)                                */
 /************************************************************************/
 
-/// @brief Set the speed of the specified robot in cm/s (will calculate motor speed in rpms)
-/// @param motor Which motor the speed is being set on
-/// @param speed The intended speed of the robot in cm/s
-int set_motor_speed(Motor motor, float speed);
+/// @brief Set the ramp target for every motor on the side (caller must keep the ramp timer out)
+/// @param side Which side of the robot is being set
+/// @param velocity The velocity to ramp the motors to in cm/s
+void set_side_target(MotorSide side, fix16_t velocity);
+
+/// @brief Calculate the duty for the speed of the specified robot in cm/s (will calculate motor speed in rpms)
+/// @param motor Which motor the speed is being calculated for
+/// @param speed The intended speed of the robot in cm/s (fixed point)
+/// @return The duty to apply to the motor's speed pin
+int calculate_duty(Motor motor, fix16_t speed);
 
 /// @brief Set the direction of the specified motor to either forward or reverse
 /// @param motor Which motor the direction is being set on
 /// @param dir The direction the robot should move (forward or reverse)
 void set_motor_direction(Motor motor, MotorDirection dir);
 
-/// @brief Set the motor speed and direction all in one
-/// @param motor Which motor the speed is being set on
-/// @param speed The intended speed of the robot in cm/s
-/// @param dir The direction the robot should move (forward or reverse)
-void set_motor_dir_speed(Motor motor, float speed, MotorDirection dir);
-
 /// @brief Get the specified pin type for the specified motor
 /// @param motor Which motor the speed is being set on
 /// @param pinType What type of pin should be retrieved (direction pin, or speed pin)
 /// @return The pin value to be used in GPIO functions
 int get_pin(Motor motor, MotorPinType pinType);
+
+/// @brief Look up the duty needed to reach the rpm using the motor's calibration table
+/// @param motor Which motor the duty is for (must have a valid calibration)
+/// @param rpm The intended rpm of the motor
+/// @return The duty to apply, interpolated between the two closest measured points
+int get_calibrated_duty(Motor motor, int rpm);
+
+/// @brief Timer callback that steps every motor's ramp towards its target velocity
+/// and then applies the new directions and duties to all the motors together
+/// @param timer The repeating timer that fired
+/// @return true to keep the timer repeating
+bool ramp_update(repeating_timer_t *timer);
+
+/// @brief Step a single motor's velocity towards its target, limited by acceleration and jerk
+/// @param motor Which motor is being stepped
+void ramp_step(Motor motor);
+
+/// @brief Simple checksum over the calibration saved before the store, so a blank or partially written sector is rejected
+/// @param data The bytes to check
+/// @param length How many bytes to check
+/// @return The checksum of the bytes
+uint32_t calibration_checksum(const uint8_t * data, size_t length);
  
 /************************************************************************/
 /* Global Variables                                                     */
 /************************************************************************/
 
 // The list of slice for the motors where the key is the motor number (enum), and the value is the slice number
-volatile uint motor_slices[6];
+volatile uint motor_slices[MOTOR_COUNT];
+
+// The direction and speed (enable) pins for the motors where the key is the motor number (enum)
+const struct {
+    int direction;
+    int speed;
+} motor_pins[MOTOR_COUNT] = {
+    { M1, EN1 },    // Motor_FL
+    { M2, EN2 },    // Motor_FR
+    { M3, EN3 },    // Motor_ML
+    { M4, EN4 },    // Motor_MR
+    { M5, EN5 },    // Motor_BL
+    { M6, EN6 }     // Motor_BR
+};
+
+// The motors driven together on each side of the robot
+const Motor motor_sides[2][MOTOR_COUNT / 2] = {
+    { Motor_FL, Motor_ML, Motor_BL },   // Motor_Side_Left
+    { Motor_FR, Motor_MR, Motor_BR }    // Motor_Side_Right
+};
+
+// Per motor state of the ramp generator, all velocities are signed (positive is forward)
+struct MotorRamp {
+    bool enabled;          // the motor has been initialized and should be ramped
+    fix16_t target;        // velocity being ramped towards (cm/s)
+    fix16_t velocity;      // velocity currently applied to the motor (cm/s)
+    fix16_t acceleration;  // current rate of change of the velocity (cm/s^2)
+};
+
+volatile struct MotorRamp motor_ramps[MOTOR_COUNT];
+
+// Timer driving the ramp generator at MOTOR_RAMP_RATE_HZ
+repeating_timer_t ramp_timer;
+
+// How close (in counts) to the end of the PWM period we allow new levels to be written
+// Each count is 27 system clocks, which leaves plenty of time to write all the levels
+#define MOTOR_LEVEL_WRITE_MARGIN 4
+
+// Half the distance between the left and right wheels, in cm (wheel speed = angular speed * half track)
+#define MOTOR_HALF_TRACK FIX16_FROM_FLOAT(WHEEL_TRACK * 100 / 2)
+// Fastest the wheels can go in cm/s, used to scale back arcs that would ask for more
+#define MOTOR_MAX_SPEED FIX16_FROM_FLOAT(MAX_RPM * 3.14159265358979 * WHEEL_DIAMETER * 100 / 60)
+
+// Change in velocity/acceleration allowed for each step of the ramp (folded at compile time)
+#define MOTOR_RAMP_DT          FIX16_FROM_FLOAT(1.0 / MOTOR_RAMP_RATE_HZ)
+#define MOTOR_RAMP_ACCEL_LIMIT FIX16_FROM_INT(MOTOR_RAMP_MAX_ACCEL)
+#define MOTOR_RAMP_JERK_STEP   FIX16_FROM_FLOAT((double) MOTOR_RAMP_MAX_JERK / MOTOR_RAMP_RATE_HZ)
+#define MOTOR_RAMP_TWO_JERK    FIX16_FROM_INT(2 * MOTOR_RAMP_MAX_JERK)
+
+// The duty to rpm tables for each motor, indexed the same as the slices
+struct MotorCalibration motor_calibrations[MOTOR_COUNT];
+
+// Format of the calibration tables in the store (tables for all 6 motors, indexed from Motor_FL = 0)
+#define MOTOR_CALIBRATION_VERSION 2
+
+// Before the store, the tables were kept in their own record in the last sector of flash
+// (they're moved into the store the first time they're loaded, the sector is part of the store's calibration area now)
+#define MOTOR_CALIBRATION_LEGACY_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define MOTOR_CALIBRATION_LEGACY_MAGIC 0x3241434D // "MCA2"
+
+// Layout of the record the tables used to be kept in
+struct MotorCalibrationRecord {
+    uint32_t magic;
+    struct MotorCalibration calibrations[MOTOR_COUNT];
+    uint32_t checksum;
+};
 
 /************************************************************************/
 /* Header Implementation                                                */
@@ -51,8 +141,20 @@ volatile uint motor_slices[6];
 
 void motor_init_all(void) 
 {
-    (void) motor_init(Motor_FL);
-    (void) motor_init(Motor_FR);
+    int motor;
+    uint32_t sliceMask = 0;
+
+    for(motor = 0; motor < MOTOR_COUNT; ++motor)
+    {
+        sliceMask |= 1u << motor_init(motor);
+        pwm_set_counter(motor_slices[motor], 0);
+    }
+    // start all the slices on the same clock cycle, with one write, so their periods line up (see ramp_update)
+    pwm_set_mask_enabled(sliceMask);
+    // use the measured duty to rpm tables if we have them, otherwise speeds are assumed linear
+    (void) motor_calibration_load();
+    // start updating the duty of the motors as they ramp (negative delay keeps the rate fixed regardless of callback time)
+    add_repeating_timer_us(-1000000 / MOTOR_RAMP_RATE_HZ, ramp_update, NULL, &ramp_timer);
 }
 
 uint motor_init(Motor motor) 
@@ -71,95 +173,347 @@ uint motor_init(Motor motor)
     pwm_set_wrap(motor_slices[motor], MOTOR_PERIOD - 1);
     // set divisor to largest possible (255) in order to get slowest possible frequency (~1.9kHz)
     pwm_set_clkdiv_int_frac(motor_slices[motor], 27, 0); // calculated as 125k / freq / 16 / 16
+    // start the ramp from stopped
+    motor_ramps[motor].target = 0;
+    motor_ramps[motor].velocity = 0;
+    motor_ramps[motor].acceleration = 0;
+    motor_ramps[motor].enabled = 1;
     return motor_slices[motor];
 }
 
 void motor_stop(Motor motor)
 {
+    // don't let the ramp timer step the motor in between clearing its state and zeroing the duty
+    uint32_t interrupts = save_and_disable_interrupts();
+    motor_ramps[motor].target = 0;
+    motor_ramps[motor].velocity = 0;
+    motor_ramps[motor].acceleration = 0;
+    // A level of 0 holds the output low from the next wrap of the slice (every ~55us), so the slice is left
+    // running rather than waiting around to disable it. This keeps stop safe to call from an alarm/interrupt
     pwm_set_gpio_level(get_pin(motor, Motor_PinType_Speed), 0);
-    sleep_ms(1);
-    pwm_set_enabled(motor_slices[motor], false);
-    sleep_ms(1);
-    gpio_put(get_pin(motor, Motor_PinType_Speed), 0);
+    restore_interrupts(interrupts);
+}
+
+void motor_forward(Motor motor, fix16_t speed)
+{
+    motor_set_velocity(motor, speed);
+}
+
+void motor_reverse(Motor motor, fix16_t speed)
+{
+    motor_set_velocity(motor, -speed);
+}
+
+void motor_set_velocity(Motor motor, fix16_t velocity)
+{
+    // the ramp timer picks up the new target on its next step
+    motor_ramps[motor].target = velocity;
+}
+
+fix16_t motor_get_velocity(Motor motor)
+{
+    return motor_ramps[motor].velocity;
+}
+
+void motor_stop_all(void)
+{
+    int motor;
+    for(motor = 0; motor < MOTOR_COUNT; ++motor)
+        motor_stop(motor);
+}
+
+void motor_side_set_velocity(MotorSide side, fix16_t velocity)
+{
+    // set the whole side together so the ramp timer never steps part of it towards the new target
+    uint32_t interrupts = save_and_disable_interrupts();
+    set_side_target(side, velocity);
+    restore_interrupts(interrupts);
+}
+
+void motor_set_differential(fix16_t left, fix16_t right)
+{
+    // set both sides together so the ramp timer never steps one side towards its new target without the other
+    uint32_t interrupts = save_and_disable_interrupts();
+    set_side_target(Motor_Side_Left, left);
+    set_side_target(Motor_Side_Right, right);
+    restore_interrupts(interrupts);
+}
+
+void motor_set_twist(fix16_t linear, fix16_t angular)
+{
+    // the wheels travel faster/slower than the centre of the robot by the angular speed times half the track
+    fix16_t offset = fix16_mul(angular, MOTOR_HALF_TRACK);
+    fix16_t left = linear - offset;
+    fix16_t right = linear + offset;
+    fix16_t fastest = left < 0 ? -left : left;
+
+    if(right > fastest)
+        fastest = right;
+    else if(-right > fastest)
+        fastest = -right;
+
+    // scale both sides back by the same amount if one side can't keep up, so the robot still follows the same arc
+    if(fastest > MOTOR_MAX_SPEED)
+    {
+        fix16_t scale = fix16_div(MOTOR_MAX_SPEED, fastest);
+        left = fix16_mul(left, scale);
+        right = fix16_mul(right, scale);
+    }
+
+    motor_set_differential(left, right);
+}
+
+int motor_calibrate(Motor motor, MotorRpmReader read_rpm)
+{
+    struct MotorCalibration calibration;
+    int i;
+
+    calibration.deadband = 0;
+    calibration.valid = 0;
+
+    // take the motor away from the ramp generator while we drive the duty directly
+    motor_ramps[motor].enabled = 0;
+    set_motor_direction(motor, Motor_Forward);
+
+    for(i = 0; i < MOTOR_CALIBRATION_POINTS; ++i)
+    {
+        int sample;
+        int total = 0;
+        // step evenly from the first step above stopped up to the full period
+        uint16_t duty = ((i + 1) * MOTOR_PERIOD) / MOTOR_CALIBRATION_POINTS;
+
+        pwm_set_gpio_level(get_pin(motor, Motor_PinType_Speed), duty);
+        sleep_ms(MOTOR_CALIBRATION_SETTLE_MS);
+
+        // average a few encoder readings to smooth out the jitter in the encoder counts
+        for(sample = 0; sample < MOTOR_CALIBRATION_SAMPLES; ++sample)
+        {
+            total += read_rpm(motor);
+            sleep_ms(MOTOR_CALIBRATION_SAMPLE_MS);
+        }
+
+        calibration.duty[i] = duty;
+        calibration.rpm[i] = total / MOTOR_CALIBRATION_SAMPLES;
+
+        // the lookup expects the rpm to only ever go up, so flatten any noise that dips below the previous step
+        if(i > 0 && calibration.rpm[i] < calibration.rpm[i - 1])
+            calibration.rpm[i] = calibration.rpm[i - 1];
+
+        // the first duty that actually moved the wheel is the edge of the deadband
+        if(!calibration.deadband && calibration.rpm[i] > 0)
+            calibration.deadband = duty;
+
+        printf("\ncalibrate motor %d: duty %d ==> %d rpm", motor, duty, calibration.rpm[i]);
+    }
+
+    motor_stop(motor);
+    motor_ramps[motor].enabled = 1;
+
+    // a motor that never turned would leave us with a useless table, so keep the linear fallback instead
+    calibration.valid = calibration.deadband != 0;
+    if(calibration.valid)
+        motor_calibrations[motor] = calibration;
+
+    return calibration.valid;
 }
 
-void motor_forward(Motor motor, float speed)
+bool motor_calibration_load(void)
 {
-    set_motor_dir_speed(motor, speed, Motor_Forward);
+    const struct MotorCalibrationRecord * record = 
+        (const struct MotorCalibrationRecord *) (XIP_BASE + MOTOR_CALIBRATION_LEGACY_OFFSET);
+
+    if(store_load(Store_Record_MotorCalibration, MOTOR_CALIBRATION_VERSION, motor_calibrations, sizeof(motor_calibrations)))
+        return 1;
+
+    // nothing in the store yet, but there may be tables from before it (that haven't been saved over yet)
+    if(record->magic == MOTOR_CALIBRATION_LEGACY_MAGIC &&
+       record->checksum == calibration_checksum((const uint8_t *) record->calibrations, sizeof(record->calibrations)))
+    {
+        memcpy(motor_calibrations, record->calibrations, sizeof(motor_calibrations));
+        motor_calibration_save();
+        printf("\nmoved the motor calibration into the store");
+        return 1;
+    }
+
+    printf("\nno motor calibration stored, using linear duty");
+    return 0;
 }
 
-void motor_reverse(Motor motor, float speed)
+void motor_calibration_save(void)
 {
-    set_motor_dir_speed(motor, speed, Motor_Reverse);
+    (void) store_save(Store_Record_MotorCalibration, MOTOR_CALIBRATION_VERSION, motor_calibrations, sizeof(motor_calibrations));
 }
 
 /************************************************************************/
 /* Local  Implementation                                                */
 /************************************************************************/
 
-void set_motor_dir_speed(Motor motor, float speed, MotorDirection dir)
+void set_side_target(MotorSide side, fix16_t velocity)
 {
-    set_motor_direction(motor, dir);
-    set_motor_speed(motor, speed);
+    int i;
+    for(i = 0; i < MOTOR_COUNT / 2; ++i)
+        motor_ramps[motor_sides[side][i]].target = velocity;
 }
 
-int set_motor_speed(Motor motor, float speed) 
+int calculate_duty(Motor motor, fix16_t speed) 
 {
-    // a flag indicating if the speed exceeded the maximum value for RPM
-    int maxed = 0;
-    // Calculated RPM of the motor based on the desired speed (in cm, converted to m), pi, and wheel diameter
-    int rpm = 60 * (speed / 100.0) / (M_PI * WHEEL_DIAMETER);
-    // Desired duty to apply to motor based on the rpm and stored period
-    int duty;
+    // Calculated RPM of the motor based on the desired speed (the cm/s to rpm factor is folded at compile time)
+    fix16_t rpm = fix16_mul(speed, MOTOR_RPM_PER_CMS);
 
     // exceeded the max rpm, set to max
-    if(rpm > MAX_RPM)
+    if(rpm > FIX16_FROM_INT(MAX_RPM))
+        rpm = FIX16_FROM_INT(MAX_RPM);
+
+    // Use the measured response of this specific motor if we have it
+    if(motor_calibrations[motor].valid)
+        return get_calibrated_duty(motor, FIX16_TO_INT(rpm));
+
+    // Calculate duty as: (rpm/MAX_RPM) * period
+    return FIX16_TO_INT(fix16_mul(rpm, MOTOR_DUTY_PER_RPM));
+}
+
+bool ramp_update(repeating_timer_t *timer)
+{
+    int motor;
+    uint32_t directionMask = 0;
+    uint32_t directions = 0;
+    uint16_t duties[MOTOR_COUNT];
+    uint32_t interrupts;
+
+    // work out everything up front so the writes below are as close together as possible
+    for(motor = 0; motor < MOTOR_COUNT; ++motor)
     {
-        rpm = MAX_RPM;
-        maxed = 1;
-    }
+        if(!motor_ramps[motor].enabled)
+            continue;
 
-    // Calculate duty as: (rpm/MAX_RPM) * period [but keep numerator large]
-    duty = (rpm * MOTOR_PERIOD) / MAX_RPM;
+        ramp_step(motor);
 
-    // TODO: Need a method to grab current encoder speed in order to maintain speed of motors after having set it?
+        // a reversal ramps down through 0 before the direction pin flips, so the motor is never slammed into reverse
+        directionMask |= 1u << get_pin(motor, Motor_PinType_Direction);
+        if(motor_ramps[motor].velocity < 0)
+        {
+            directions |= 1u << get_pin(motor, Motor_PinType_Direction);
+            duties[motor] = calculate_duty(motor, -motor_ramps[motor].velocity);
+        }
+        else
+        {
+            duties[motor] = calculate_duty(motor, motor_ramps[motor].velocity);
+        }
+    }
 
-    // Set the duty of the signal
-    pwm_set_gpio_level(get_pin(motor, Motor_PinType_Speed), duty);
-    // Set the PWM running (turn on the motor, at the set speed)
-    pwm_set_enabled(motor_slices[motor], true);
+    interrupts = save_and_disable_interrupts();
+    // All the slices count in lockstep and latch new levels when they wrap, so the new duties take effect in the 
+    // same period as long as a wrap doesn't land part way through writing them. If we're right at the end of
+    // the period, wait for it to wrap first
+    while(pwm_get_counter(motor_slices[Motor_FL]) >= MOTOR_PERIOD - MOTOR_LEVEL_WRITE_MARGIN);
+    gpio_put_masked(directionMask, directions);
+    for(motor = 0; motor < MOTOR_COUNT; ++motor)
+    {
+        if(motor_ramps[motor].enabled)
+            pwm_set_gpio_level(get_pin(motor, Motor_PinType_Speed), duties[motor]);
+    }
+    restore_interrupts(interrupts);
 
-    return maxed;
+    return true;
 }
 
-void set_motor_direction(Motor motor, MotorDirection dir)
+void ramp_step(Motor motor)
 {
-    gpio_put(get_pin(motor, Motor_PinType_Direction), dir);
+    volatile struct MotorRamp * ramp = &motor_ramps[motor];
+    fix16_t error = ramp->target - ramp->velocity;
+    fix16_t distance = error < 0 ? -error : error;
+    fix16_t step = error < 0 ? -MOTOR_RAMP_JERK_STEP : MOTOR_RAMP_JERK_STEP;
+    // how much more the velocity would change if we started bringing the acceleration back to 0 now (a^2 / 2j)
+    fix16_t easing = fix16_div(fix16_mul(ramp->acceleration, ramp->acceleration), MOTOR_RAMP_TWO_JERK);
+
+    // already there and holding, nothing to update
+    if(error == 0 && ramp->acceleration == 0)
+        return;
+
+    // already accelerating towards the target and close enough that we need to ease off to land on it
+    if((error > 0) == (ramp->acceleration > 0) && ramp->acceleration != 0 && distance <= easing)
+    {
+        ramp->acceleration -= step;
+    }
+    else
+    {
+        ramp->acceleration += step;
+        if(ramp->acceleration > MOTOR_RAMP_ACCEL_LIMIT)
+            ramp->acceleration = MOTOR_RAMP_ACCEL_LIMIT;
+        else if(ramp->acceleration < -MOTOR_RAMP_ACCEL_LIMIT)
+            ramp->acceleration = -MOTOR_RAMP_ACCEL_LIMIT;
+    }
+
+    ramp->velocity += fix16_mul(ramp->acceleration, MOTOR_RAMP_DT);
+
+    // reached (or passed) the target, so settle on it exactly
+    if((error > 0 && ramp->velocity >= ramp->target) || (error < 0 && ramp->velocity <= ramp->target))
+    {
+        ramp->velocity = ramp->target;
+        ramp->acceleration = 0;
+    }
 }
 
-int get_pin(Motor motor, MotorPinType pinType)
+int get_calibrated_duty(Motor motor, int rpm)
 {
-    int dirPin; //which pin to use for direction of motor (0/1) [F/R]
-    int speedPin; // which pin to set for speed (enable) of motor (0-255)
+    const struct MotorCalibration * calibration = &motor_calibrations[motor];
+    int i;
+    int duty;
 
-    switch(motor)
+    if(rpm <= 0)
+        return 0;
+
+    // find the first measured point that reaches the requested rpm
+    for(i = 0; i < MOTOR_CALIBRATION_POINTS; ++i)
     {
-        case Motor_FL:
-            dirPin = M1;
-            speedPin = EN1;
-            break;
-        case Motor_FR:
-            dirPin = M2;
-            speedPin = EN2;
+        if(calibration->rpm[i] >= rpm)
             break;
     }
 
+    // faster than the motor was ever measured going, so give it everything
+    if(i == MOTOR_CALIBRATION_POINTS)
+        return calibration->duty[MOTOR_CALIBRATION_POINTS - 1];
+
+    if(i == 0 || calibration->rpm[i] == calibration->rpm[i - 1])
+    {
+        duty = calibration->duty[i];
+    }
+    else
+    {
+        // linearly interpolate between the two measured points either side of the rpm
+        duty = calibration->duty[i - 1] + 
+            ((rpm - calibration->rpm[i - 1]) * (calibration->duty[i] - calibration->duty[i - 1])) /
+            (calibration->rpm[i] - calibration->rpm[i - 1]);
+    }
+
+    // anything below the deadband won't move the wheel at all
+    return duty < calibration->deadband ? calibration->deadband : duty;
+}
+
+uint32_t calibration_checksum(const uint8_t * data, size_t length)
+{
+    uint32_t checksum = 0;
+    while(length--)
+    {
+        // rotate before adding so swapped bytes don't produce the same sum
+        checksum = (checksum << 1 | checksum >> 31) + *data++;
+    }
+    return checksum;
+}
+
+void set_motor_direction(Motor motor, MotorDirection dir)
+{
+    gpio_put(get_pin(motor, Motor_PinType_Direction), dir);
+}
+
+int get_pin(Motor motor, MotorPinType pinType)
+{
     switch(pinType)
     {
         case Motor_PinType_Direction:
-            return dirPin;
+            return motor_pins[motor].direction;
         case Motor_PinType_Speed:
-            return speedPin;
+            return motor_pins[motor].speed;
     }
     return -1;
 }
\ No newline at end of file
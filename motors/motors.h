@@ -7,28 +7,74 @@
  * Created: 2023-03-20
  * Author: Kia Skretteberg
  */
+#ifndef MOTORSH
+#define MOTORSH
 
-// MOTOR 3 is not working (pins 11/12)
+#include "../fixed/fixed.h"
 
-#define M1 2    // GPIO 2 [pin 4]
-#define EN1 3   // GPIO 3 [pin 5]
+// MOTOR 3 is not working (pins 11/12), so the middle/back motors are on the pins after it
+// Each speed pin must be on a different PWM slice/channel (slice = (GPIO / 2) % 8, channel = GPIO % 2)
 
-#define M2 6    // GPIO 6 [pin 9]
-#define EN2 7   // GPIO 7 [pin 10]
+#define M1 2    // GPIO 2 [pin 4]   front left
+#define EN1 3   // GPIO 3 [pin 5]   slice 1B
+
+#define M2 6    // GPIO 6 [pin 9]   front right
+#define EN2 7   // GPIO 7 [pin 10]  slice 3B
+
+#define M3 10   // GPIO 10 [pin 14] middle left
+#define EN3 11  // GPIO 11 [pin 15] slice 5B
+
+#define M4 12   // GPIO 12 [pin 16] middle right
+#define EN4 13  // GPIO 13 [pin 17] slice 6B
+
+#define M5 14   // GPIO 14 [pin 19] back left
+#define EN5 15  // GPIO 15 [pin 20] slice 7B
+
+#define M6 20   // GPIO 20 [pin 26] back right
+#define EN6 21  // GPIO 21 [pin 27] slice 2B
+
+#define MOTOR_COUNT 6
 
 
 #define WHEEL_DIAMETER 0.065 // in m
+#define WHEEL_TRACK 0.30 // in m, distance between the centre of the left and right wheels
 #define MAX_RPM 140 // from datasheet for 36GP-555-27-EN motors, max rated torque speed
 #define MOTOR_PERIOD 254 // max value as specified by datasheet for motor controllers: DRI0002
 
+// rpm for every 1 cm/s of robot speed: 60s * (cm ==> m) / wheel circumference
+#define MOTOR_RPM_PER_CMS FIX16_FROM_FLOAT(60 * (1 / 100.0) / (3.14159265358979 * WHEEL_DIAMETER))
+// duty for every 1 rpm when the motor has not been calibrated (assumes rpm scales linearly with duty)
+#define MOTOR_DUTY_PER_RPM FIX16_FROM_FLOAT((double) MOTOR_PERIOD / MAX_RPM)
+
+#define MOTOR_RAMP_RATE_HZ    100  // how often the ramp generator updates the duty of each motor
+#define MOTOR_RAMP_MAX_ACCEL  60   // max change in speed in cm/s^2 (0 to 40cm/s takes ~0.8s)
+#define MOTOR_RAMP_MAX_JERK   300  // max change in acceleration in cm/s^3 (softens the start and end of each ramp)
+
+#define MOTOR_CALIBRATION_POINTS    16   // number of duty steps sampled for each motor when building its duty to rpm table
+#define MOTOR_CALIBRATION_SETTLE_MS 400  // time given to the motor to reach a steady speed after each duty change
+#define MOTOR_CALIBRATION_SAMPLES   5    // number of encoder readings averaged at each duty step
+#define MOTOR_CALIBRATION_SAMPLE_MS 100  // time between encoder readings (atmega reports the encoders roughly every 100ms)
+
 /** \brief Selector for specific motor:
  *  \ingroup motors
  */
 typedef enum {
-    Motor_FL = 1,
-    Motor_FR = 2
+    Motor_FL = 0,
+    Motor_FR = 1,
+    Motor_ML = 2,
+    Motor_MR = 3,
+    Motor_BL = 4,
+    Motor_BR = 5
 } Motor;
 
+/** \brief Selector for the group of motors on one side of the robot:
+ *  \ingroup motors
+ */
+typedef enum {
+    Motor_Side_Left,
+    Motor_Side_Right
+} MotorSide;
+
 /** \brief Selector for motor direction:
  *  \ingroup motors
  */
@@ -46,8 +92,47 @@ typedef enum {
     Motor_PinType_Speed
 } MotorPinType;
 
+/** \brief Duty to rpm table for a single motor, measured by sweeping the duty and reading the encoder
+ *  \ingroup motors
+ */
+struct MotorCalibration {
+    uint16_t duty[MOTOR_CALIBRATION_POINTS]; // duty applied at each step of the sweep (ascending)
+    uint8_t rpm[MOTOR_CALIBRATION_POINTS];   // steady rpm measured at that duty (forced to be non-decreasing)
+    uint16_t deadband;                       // smallest duty that actually turned the wheel
+    bool valid;                              // false until the motor has been calibrated (falls back to linear duty)
+};
+
+// Reads the current encoder speed (in RPM) of the specified motor, used while calibrating
+typedef int (*MotorRpmReader)(Motor motor);
+
 void motor_init_all(void);
 uint motor_init(Motor motor);
+// Stop the motor immediately (no ramp), used for stopping at obstacles and drops
 void motor_stop(Motor motor);
-void motor_forward(Motor motor, float speed);
-void motor_reverse(Motor motor, float speed);
\ No newline at end of file
+// Ramp the motor up/down to the speed (cm/s) going forward, ramping through 0 if it was going in reverse
+void motor_forward(Motor motor, fix16_t speed);
+// Ramp the motor up/down to the speed (cm/s) going in reverse, ramping through 0 if it was going forward
+void motor_reverse(Motor motor, fix16_t speed);
+// Ramp the motor to the velocity (cm/s), positive is forward and negative is reverse
+void motor_set_velocity(Motor motor, fix16_t velocity);
+// Get the velocity (cm/s) the ramp generator is currently driving the motor at
+fix16_t motor_get_velocity(Motor motor);
+// Stop every motor immediately
+void motor_stop_all(void);
+// Ramp all the motors on one side of the robot to the velocity (cm/s), positive is forward
+void motor_side_set_velocity(MotorSide side, fix16_t velocity);
+// Ramp the left and right sides to their velocities (cm/s), every motor is updated in the same PWM period
+void motor_set_differential(fix16_t left, fix16_t right);
+// Drive the robot along an arc, linear speed in cm/s (positive is forward)
+// and angular speed in rad/s (positive is counter-clockwise, turning left)
+void motor_set_twist(fix16_t linear, fix16_t angular);
+
+// Sweep the duty of the motor from stopped to full, recording the encoder rpm at each step into the motor's table
+// The wheel must be free to spin. Returns 1 if the motor was seen turning, 0 otherwise
+int motor_calibrate(Motor motor, MotorRpmReader read_rpm);
+// Load the calibration tables from the store, returns 1 if valid tables were found (store_init must have been called)
+bool motor_calibration_load(void);
+// Save the current calibration tables to the store so they survive a reboot
+void motor_calibration_save(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,215 @@
+/*
+ * movers.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "movers.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+/// @brief Find the mover a return belongs to
+/// @param x The x position of the return (in mm)
+/// @param y The y position of the return (in mm)
+/// @param time When the return was seen (in us)
+/// @return The mover whose predicted position is closest (within the gate), NULL if there isn't one
+struct Mover * find_mover(long x, long y, uint64_t time);
+
+/// @brief Find a mover to start following a new return with
+/// @return An inactive mover, or the one seen longest ago if they're all active
+struct Mover * free_mover(void);
+
+/// @brief Work out how a mover is going from its velocity
+/// @param mover The mover (with a fix just added)
+/// @param robotX The x position of the robot (in mm)
+/// @param robotY The y position of the robot (in mm)
+/// @return How the mover is going
+Movers_Motion classify(struct Mover * mover, long robotX, long robotY);
+
+/// @brief Find the length of a velocity
+/// @param velocityX The velocity along x (in mm/s)
+/// @param velocityY The velocity along y (in mm/s)
+/// @return The speed (in mm/s)
+fix16_t speed_of(fix16_t velocityX, fix16_t velocityY);
+
+/// @brief Check if a position is in the way of the robot
+/// @param x The x position (in mm)
+/// @param y The y position (in mm)
+/// @param robotX The x position of the robot (in mm)
+/// @param robotY The y position of the robot (in mm)
+/// @param heading The heading of the robot (in rad)
+/// @return 1 if the position is ahead of the robot and close to its centre line
+bool in_way(long x, long y, long robotX, long robotY, fix16_t heading);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+struct Mover movers[MOVERS_MAX];
+
+// the robot's own positions, to tell the beam sliding along something as the robot drives from something moving
+struct Track robot;
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void movers_clear(void)
+{
+    int i;
+    for(i = 0; i < MOVERS_MAX; ++i)
+        movers[i].active = 0;
+    track_reset(&robot);
+}
+
+Movers_Motion movers_add_return(long x, long y, long robotX, long robotY, uint64_t time)
+{
+    // (all of the sensors' returns from a frame come with the same time, the robot only needs the one fix)
+    if(robot.count == 0 || robot.fixes[robot.latest].time != time)
+        track_add_fix(&robot, robotX, robotY, time);
+
+    struct Mover * mover = find_mover(x, y, time);
+    if(mover == NULL)
+    {
+        mover = free_mover();
+        track_reset(&mover->track);
+        mover->motion = Movers_Motion_Still;
+        mover->active = 1;
+    }
+    else if(mover->track.fixes[mover->track.latest].time == time)
+    {
+        return mover->motion;
+    }
+
+    track_add_fix(&mover->track, x, y, time);
+    mover->seen = time;
+    mover->motion = classify(mover, robotX, robotY);
+    return mover->motion;
+}
+
+bool movers_in_way(long x, long y, fix16_t heading, uint64_t now, uint64_t within)
+{
+    int i, step;
+
+    for(i = 0; i < MOVERS_MAX; ++i)
+    {
+        struct Mover * mover = &movers[i];
+        // something still is left to the map, and following someone walking away is fine
+        if(!mover->active || now > mover->seen + MOVERS_TIMEOUT ||
+           mover->motion == Movers_Motion_Still || mover->motion == Movers_Motion_Receding)
+            continue;
+
+        // where it is now, half way through and at the end
+        for(step = 0; step <= 2; ++step)
+        {
+            long moverX, moverY;
+            if(track_predict(&mover->track, now + within * step / 2, &moverX, &moverY) &&
+               in_way(moverX, moverY, x, y, heading))
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+struct Mover * find_mover(long x, long y, uint64_t time)
+{
+    struct Mover * closest = NULL;
+    int64_t closestDistance = (int64_t) MOVERS_GATE * MOVERS_GATE;
+    int i;
+
+    for(i = 0; i < MOVERS_MAX; ++i)
+    {
+        struct Mover * mover = &movers[i];
+        long moverX, moverY;
+
+        if(mover->active && time > mover->seen + MOVERS_TIMEOUT)
+            mover->active = 0;
+        if(!mover->active || !track_predict(&mover->track, time, &moverX, &moverY))
+            continue;
+
+        int64_t dx = x - moverX;
+        int64_t dy = y - moverY;
+        int64_t distance = dx * dx + dy * dy;
+        if(distance <= closestDistance)
+        {
+            closest = mover;
+            closestDistance = distance;
+        }
+    }
+
+    return closest;
+}
+
+struct Mover * free_mover(void)
+{
+    struct Mover * oldest = &movers[0];
+    int i;
+
+    for(i = 0; i < MOVERS_MAX; ++i)
+    {
+        if(!movers[i].active)
+            return &movers[i];
+        if(movers[i].seen < oldest->seen)
+            oldest = &movers[i];
+    }
+
+    return oldest;
+}
+
+Movers_Motion classify(struct Mover * mover, long robotX, long robotY)
+{
+    struct Track * track = &mover->track;
+    struct TrackFix * latest = &track->fixes[track->latest];
+
+    if(track->count < MOVERS_MIN_FIXES)
+        return Movers_Motion_Still;
+
+    // still, or keeping pace with the robot (the same spot on the beam sliding along something that isn't moving)
+    fix16_t speed = speed_of(track->velocityX, track->velocityY);
+    if(speed < FIX16_FROM_INT(MOVERS_MOVING_SPEED) ||
+       speed_of(track->velocityX - robot.velocityX, track->velocityY - robot.velocityY) < FIX16_FROM_INT(MOVERS_MOVING_SPEED))
+        return Movers_Motion_Still;
+
+    // how much of the velocity is away from the robot (mm/s)
+    long dx = latest->x - robotX;
+    long dy = latest->y - robotY;
+    fix16_t metresX = FIX16_FROM_INT(dx) / 1000;
+    fix16_t metresY = FIX16_FROM_INT(dy) / 1000;
+    long distance = FIX16_TO_INT(fix16_sqrt(fix16_mul(metresX, metresX) + fix16_mul(metresY, metresY)) * 1000);
+    if(distance == 0)
+        return Movers_Motion_Approaching;
+    fix16_t radial = (fix16_t) (((int64_t) track->velocityX * dx + (int64_t) track->velocityY * dy) / distance);
+
+    // within 60 degrees of straight at (or away from) the robot
+    if(radial <= -speed / 2)
+        return Movers_Motion_Approaching;
+    if(radial >= speed / 2)
+        return Movers_Motion_Receding;
+    return Movers_Motion_Crossing;
+}
+
+fix16_t speed_of(fix16_t velocityX, fix16_t velocityY)
+{
+    // in m/s, so the square still fits
+    velocityX /= 1000;
+    velocityY /= 1000;
+    return fix16_sqrt(fix16_mul(velocityX, velocityX) + fix16_mul(velocityY, velocityY)) * 1000;
+}
+
+bool in_way(long x, long y, long robotX, long robotY, fix16_t heading)
+{
+    fix16_t dx = FIX16_FROM_INT(x - robotX);
+    fix16_t dy = FIX16_FROM_INT(y - robotY);
+    long ahead = FIX16_TO_INT(fix16_mul(dx, fix16_cos(heading)) + fix16_mul(dy, fix16_sin(heading)));
+    long side = FIX16_TO_INT(fix16_mul(dy, fix16_cos(heading)) - fix16_mul(dx, fix16_sin(heading)));
+
+    return ahead >= 0 && ahead <= MOVERS_WAY_DISTANCE && abs(side) <= MOVERS_WAY_WIDTH;
+}
\ No newline at end of file
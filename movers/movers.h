@@ -0,0 +1,59 @@
+/*
+ * movers.h
+ * Telling things that move (people and pets walking past) apart from things that don't, from the ultrasonic returns
+ *
+ * Each return (where the ultrasonics saw something, in UWB coordinates) is given to the mover whose predicted position
+ * it is closest to (within MOVERS_GATE), or starts a new one. Every mover is a track (see track), so it has a velocity
+ * and can be predicted a little way ahead. A mover that is slower than MOVERS_MOVING_SPEED, or that is going along with
+ * the robot (the beam sliding along a wall the robot is driving beside), is still; otherwise it is approaching, receding
+ * or crossing depending on which way it is going relative to the robot
+ *
+ * The ultrasonics only give a range, so the returns are put on the middle of each beam and the velocities are rough,
+ * but good enough to tell someone walking across the robot's way from a chair
+ *
+ * Created: 2026-10-19
+ */
+#ifndef MOVERSH
+#define MOVERSH
+
+#include "pico/stdlib.h"
+#include "../fixed/fixed.h"
+#include "../track/track.h"
+
+#define MOVERS_MAX              4       // movers followed at once (the one seen longest ago is replaced)
+#define MOVERS_GATE             400     // mm from a mover's predicted position a return can be and still belong to it
+#define MOVERS_TIMEOUT          1000000 // us without a return before a mover is forgotten
+#define MOVERS_MIN_FIXES        3       // returns a mover needs before it can be anything but still
+#define MOVERS_MOVING_SPEED     200     // mm/s, slower than this is still (the returns wander about this much by themselves)
+#define MOVERS_WAY_DISTANCE     1000    // mm ahead of the robot that counts as in its way
+#define MOVERS_WAY_WIDTH        350     // mm either side of the robot's centre line that counts as in its way
+
+/** \brief How a mover is going:
+ *  \ingroup movers
+ */
+typedef enum {
+    Movers_Motion_Still,        // (or not seen enough yet to tell)
+    Movers_Motion_Approaching,  // coming mostly towards the robot
+    Movers_Motion_Receding,     // going mostly away from the robot
+    Movers_Motion_Crossing      // going mostly across in front of the robot
+} Movers_Motion;
+
+struct Mover {
+    struct Track track;         // where the returns were, and the velocity fitted through them
+    uint64_t seen;              // us, when the last return was
+    Movers_Motion motion;
+    bool active;
+};
+
+// Forget all of the movers
+void movers_clear(void);
+
+// Add a return (in mm) seen at a time (in us) with the robot at a position (in mm), returns how the mover it belongs
+// to is going (only one return is taken for each mover at a time, so two sensors seeing it don't confuse the velocity)
+Movers_Motion movers_add_return(long x, long y, long robotX, long robotY, uint64_t time);
+
+// Check if anything approaching or crossing is in the way of the robot at a position (in mm) facing a heading (in rad),
+// now or at any point up to a time (in us) from now
+bool movers_in_way(long x, long y, fix16_t heading, uint64_t now, uint64_t within);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,621 @@
+/*
+ * planner.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "planner.h"
+#include "../geofence/geofence.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+#define PLANNER_CELLS       (PLANNER_WIDTH * PLANNER_HEIGHT)
+#define PLANNER_CELL_SIZE   (GRID_CELL_SIZE * PLANNER_SCALE) // mm
+
+// keep out zones are looked up by planner cell
+#if PLANNER_SCALE != GEOFENCE_SCALE
+#error "the planner and geofence cells must be the same size"
+#endif
+
+// Node flags (the low 3 bits are the direction the node was reached in)
+#define PLANNER_DIRECTION   0x07
+#define PLANNER_REACHED     0x08 // has a cost (and a direction, unless it's the start)
+#define PLANNER_CLOSED      0x10 // has been expanded
+
+/** \brief What the planner is doing between steps:
+ *  \ingroup planner
+ */
+typedef enum {
+    Planner_Phase_Idle,
+    Planner_Phase_Copying,
+    Planner_Phase_Searching,
+    Planner_Phase_Done
+} Planner_Phase;
+
+/// @brief Copy the next rows of the grid into the occupied/unknown maps
+void copy_rows(void);
+
+/// @brief Expand the cheapest nodes in the open list
+/// @param expansions The most nodes to expand
+void expand(int expansions);
+
+/// @brief Turn the finished search into waypoints
+void build_waypoints(void);
+
+/// @brief Check if something is in a cell, using the copied grid
+/// @param index The index of the planner cell
+/// @return 1 if occupied
+bool is_occupied(int index);
+
+/// @brief Check if the robot can't be in a cell (it or one of its neighbours is occupied), using the copied grid
+/// @param index The index of the planner cell
+/// @return 1 if blocked
+bool is_blocked(int index);
+
+/// @brief Check if the robot can't be in a cell, straight from the latest grid
+/// @param index The index of the planner cell
+/// @return 1 if blocked
+bool is_blocked_now(int index);
+
+/// @brief Check if there's a clear straight line between two cells
+/// @param from The index of the first planner cell
+/// @param to The index of the second planner cell
+/// @param now 1 to only look for cells that have become blocked since the grid was copied, 0 to use the copy
+/// @return 1 if nothing is in the way
+bool line_is_clear(int from, int to, bool now);
+
+/// @brief Check a path to follow is still clear from the start to the goal, using the copied grid
+/// @return 1 if nothing is in the way
+bool path_is_clear(void);
+
+/// @brief Estimate of the cost between a cell and the goal (octile distance)
+/// @param index The index of the planner cell
+/// @return The estimated cost
+uint16_t heuristic(int index);
+
+/// @brief Add a node to the open list
+/// @param index The index of the planner cell
+/// @param score The cost so far plus the estimate to the goal
+void open_push(uint16_t index, uint16_t score);
+
+/// @brief Take the node with the lowest score from the open list
+/// @return The index of the planner cell
+uint16_t open_pop(void);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+// neighbour offsets, by direction (the even directions are the sides)
+const int8_t direction_x[8] = { 1, 1, 0, -1, -1, -1,  0,  1 };
+const int8_t direction_y[8] = { 0, 1, 1,  1,  0, -1, -1, -1 };
+
+Planner_Phase planner_phase = Planner_Phase_Idle;
+Planner_Status planner_status = Planner_Status_Idle;
+int copy_row = 0;
+int start_cell = 0;
+int goal_cell = 0;
+long start_x = 0;
+long start_y = 0;
+long goal_x = 0;
+long goal_y = 0;
+
+// a bit for each planner cell, copied from the grid when the search starts
+uint8_t occupied_cells[PLANNER_CELLS / 8];
+uint8_t unknown_cells[PLANNER_CELLS / 8];
+
+// the search state of each planner cell
+uint16_t node_costs[PLANNER_CELLS];
+uint8_t node_flags[PLANNER_CELLS];
+
+// binary heap of nodes to expand, ordered by score (also reused to walk the path back once it's found)
+uint16_t open_nodes[PLANNER_OPEN_MAX];
+uint16_t open_scores[PLANNER_OPEN_MAX];
+int open_count = 0;
+
+// the path, as the cells it changes direction in
+uint16_t waypoint_cells[PLANNER_MAX_WAYPOINTS];
+int waypoint_count = 0;
+int waypoint_next = 0;
+
+// 1 if the path was given to planner_follow, and only has to be checked once the grid is copied
+bool planner_following = 0;
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void planner_reset(void)
+{
+    planner_phase = Planner_Phase_Idle;
+    planner_status = Planner_Status_Idle;
+    waypoint_count = 0;
+    waypoint_next = 0;
+    planner_following = 0;
+}
+
+void planner_start(long startX, long startY, long goalX, long goalY)
+{
+    planner_reset();
+    start_x = startX;
+    start_y = startY;
+    goal_x = goalX;
+    goal_y = goalY;
+
+    if(!planner_cell_from_position(startX, startY, &start_cell) || !planner_cell_from_position(goalX, goalY, &goal_cell))
+    {
+        planner_status = Planner_Status_NoPath;
+        return;
+    }
+
+    copy_row = 0;
+    planner_phase = Planner_Phase_Copying;
+    planner_status = Planner_Status_Searching;
+}
+
+void planner_follow(long startX, long startY, long goalX, long goalY, const struct PlannerPath * path)
+{
+    planner_start(startX, startY, goalX, goalY);
+    if(planner_status != Planner_Status_Searching || path->count == 0 || path->count > PLANNER_MAX_WAYPOINTS)
+        return;
+
+    // the goal is rarely in the same cell as last time, so the path finishes at this one instead
+    memcpy(waypoint_cells, path->cells, path->count * sizeof(waypoint_cells[0]));
+    waypoint_count = path->count;
+    waypoint_cells[waypoint_count - 1] = goal_cell;
+    planner_following = 1;
+}
+
+Planner_Status planner_step(int expansions)
+{
+    switch(planner_phase)
+    {
+        case Planner_Phase_Copying:
+            copy_rows();
+            break;
+        case Planner_Phase_Searching:
+            expand(expansions);
+            break;
+        case Planner_Phase_Idle:
+        case Planner_Phase_Done:
+            // nothing to do until a search is started
+            break;
+    }
+    return planner_status;
+}
+
+Planner_Status planner_get_status(void)
+{
+    return planner_status;
+}
+
+bool planner_goal_moved(long goalX, long goalY)
+{
+    long dx = goalX - goal_x;
+    long dy = goalY - goal_y;
+    return dx * dx + dy * dy > (long) PLANNER_REPLAN_DISTANCE * PLANNER_REPLAN_DISTANCE;
+}
+
+bool planner_path_blocked(void)
+{
+    int index;
+
+    if(planner_status != Planner_Status_Found || waypoint_next >= waypoint_count)
+        return 0;
+
+    // the robot is somewhere between the last waypoint and the next, so check from there on
+    int from = waypoint_next > 0 ? waypoint_cells[waypoint_next - 1] : start_cell;
+    for(index = waypoint_next; index < waypoint_count; ++index)
+    {
+        if(!line_is_clear(from, waypoint_cells[index], 1))
+            return 1;
+        from = waypoint_cells[index];
+    }
+    return 0;
+}
+
+bool planner_get_path(struct PlannerPath * path)
+{
+    if(planner_status != Planner_Status_Found || waypoint_count == 0 || waypoint_cells[waypoint_count - 1] != goal_cell)
+        return 0;
+
+    path->start = start_cell;
+    path->goal = goal_cell;
+    path->count = waypoint_count;
+    memcpy(path->cells, waypoint_cells, waypoint_count * sizeof(waypoint_cells[0]));
+    return 1;
+}
+
+long planner_estimate(long startX, long startY, long goalX, long goalY)
+{
+    long dx = labs(goalX - startX);
+    long dy = labs(goalY - startY);
+    long diagonal = dx < dy ? dx : dy;
+
+    // the same moves as the heuristic, in mm rather than cells
+    return (diagonal * PLANNER_COST_DIAGONAL + (dx + dy - 2 * diagonal) * PLANNER_COST_STRAIGHT) / PLANNER_COST_STRAIGHT;
+}
+
+bool planner_cell_from_position(long x, long y, int * index)
+{
+    int column, row;
+
+    if(!grid_cell_from_position(x, y, &column, &row))
+        return 0;
+
+    *index = row / PLANNER_SCALE * PLANNER_WIDTH + column / PLANNER_SCALE;
+    return 1;
+}
+
+bool planner_next_waypoint(long x, long y, struct PlannerWaypoint * waypoint)
+{
+    if(planner_status != Planner_Status_Found)
+        return 0;
+
+    while(waypoint_next < waypoint_count)
+    {
+        int cell = waypoint_cells[waypoint_next];
+        bool last = waypoint_next == waypoint_count - 1;
+
+        // the goal is rarely in the middle of its cell, so the path ends at the goal itself
+        if(last && cell == goal_cell)
+        {
+            waypoint->x = goal_x;
+            waypoint->y = goal_y;
+        }
+        else
+        {
+            waypoint->x = GRID_ORIGIN_X + (cell % PLANNER_WIDTH) * PLANNER_CELL_SIZE + PLANNER_CELL_SIZE / 2;
+            waypoint->y = GRID_ORIGIN_Y + (cell / PLANNER_WIDTH) * PLANNER_CELL_SIZE + PLANNER_CELL_SIZE / 2;
+        }
+
+        long dx = waypoint->x - x;
+        long dy = waypoint->y - y;
+        // keep heading for the goal even once it's close, it's up to the caller to decide when it has arrived
+        if(last && cell == goal_cell)
+            return 1;
+        if(dx * dx + dy * dy > (long) PLANNER_WAYPOINT_REACHED * PLANNER_WAYPOINT_REACHED)
+            return 1;
+
+        ++waypoint_next;
+    }
+
+    // the path was cut short to fit the waypoints, and they've all been reached
+    planner_reset();
+    return 0;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+void copy_rows(void)
+{
+    int row, column, lastRow = copy_row + PLANNER_ROWS_PER_STEP;
+
+    if(lastRow > PLANNER_HEIGHT)
+        lastRow = PLANNER_HEIGHT;
+
+    for(row = copy_row; row < lastRow; ++row)
+    {
+        for(column = 0; column < PLANNER_WIDTH; ++column)
+        {
+            int index = row * PLANNER_WIDTH + column;
+            bool occupied = 0;
+            bool known = 0;
+            int x, y;
+
+            for(y = 0; y < PLANNER_SCALE; ++y)
+            {
+                for(x = 0; x < PLANNER_SCALE; ++x)
+                {
+                    Grid_Cell cell = grid_get_cell(column * PLANNER_SCALE + x, row * PLANNER_SCALE + y);
+                    occupied |= cell == Grid_Cell_Occupied;
+                    known |= cell != Grid_Cell_Unknown;
+                }
+            }
+
+            // keep out zones are treated as obstacles, so paths go round them (with the same margin)
+            occupied |= geofence_cell_blocked(column, row);
+
+            if(occupied)
+                occupied_cells[index >> 3] |= 1 << (index & 7);
+            else
+                occupied_cells[index >> 3] &= ~(1 << (index & 7));
+
+            if(!known)
+                unknown_cells[index >> 3] |= 1 << (index & 7);
+            else
+                unknown_cells[index >> 3] &= ~(1 << (index & 7));
+        }
+    }
+    copy_row = lastRow;
+
+    // the map is copied, so a path from an earlier trip can be used as it is if it's still clear
+    if(copy_row == PLANNER_HEIGHT && planner_following)
+    {
+        planner_following = 0;
+        if(path_is_clear())
+        {
+            waypoint_next = 0;
+            planner_phase = Planner_Phase_Done;
+            planner_status = Planner_Status_Found;
+            return;
+        }
+    }
+
+    // otherwise start the search from the robot
+    if(copy_row == PLANNER_HEIGHT)
+    {
+        memset(node_flags, 0, sizeof(node_flags));
+        open_count = 0;
+        node_costs[start_cell] = 0;
+        node_flags[start_cell] = PLANNER_REACHED;
+        open_push(start_cell, heuristic(start_cell));
+        planner_phase = Planner_Phase_Searching;
+    }
+}
+
+void expand(int expansions)
+{
+    while(expansions-- > 0)
+    {
+        if(open_count == 0)
+        {
+            planner_phase = Planner_Phase_Done;
+            planner_status = Planner_Status_NoPath;
+            return;
+        }
+
+        uint16_t index = open_pop();
+
+        // nodes can be in the list more than once if a cheaper way to them was found, only the first counts
+        if(node_flags[index] & PLANNER_CLOSED)
+        {
+            ++expansions;
+            continue;
+        }
+        node_flags[index] |= PLANNER_CLOSED;
+
+        if(index == goal_cell)
+        {
+            build_waypoints();
+            planner_phase = Planner_Phase_Done;
+            planner_status = Planner_Status_Found;
+            return;
+        }
+
+        int column = index % PLANNER_WIDTH;
+        int row = index / PLANNER_WIDTH;
+        int direction;
+
+        for(direction = 0; direction < 8; ++direction)
+        {
+            int nextColumn = column + direction_x[direction];
+            int nextRow = row + direction_y[direction];
+
+            if(nextColumn < 0 || nextRow < 0 || nextColumn >= PLANNER_WIDTH || nextRow >= PLANNER_HEIGHT)
+                continue;
+
+            int next = nextRow * PLANNER_WIDTH + nextColumn;
+            if(node_flags[next] & PLANNER_CLOSED)
+                continue;
+            // the goal (the user) is often right next to something, so let the path finish there regardless
+            // and the robot may already be close to something, so let it move out of the start through anything not occupied
+            if(next != goal_cell && (index == start_cell ? is_occupied(next) : is_blocked(next)))
+                continue;
+
+            uint16_t cost = node_costs[index];
+            if(direction & 1)
+            {
+                // don't cut the corner of something
+                if(is_occupied(row * PLANNER_WIDTH + nextColumn) || is_occupied(nextRow * PLANNER_WIDTH + column))
+                    continue;
+                cost += PLANNER_COST_DIAGONAL;
+            }
+            else
+            {
+                cost += PLANNER_COST_STRAIGHT;
+            }
+            if(unknown_cells[next >> 3] & (1 << (next & 7)))
+                cost += PLANNER_COST_UNKNOWN;
+
+            if(!(node_flags[next] & PLANNER_REACHED) || cost < node_costs[next])
+            {
+                node_costs[next] = cost;
+                node_flags[next] = PLANNER_REACHED | direction;
+                open_push(next, cost + heuristic(next));
+            }
+        }
+    }
+}
+
+void build_waypoints(void)
+{
+    int length = 0;
+    int index = goal_cell;
+
+    // walk back from the goal to the start (the open list isn't needed anymore, so the path goes in there)
+    while(index != start_cell && length < PLANNER_OPEN_MAX)
+    {
+        open_nodes[length++] = index;
+        int direction = node_flags[index] & PLANNER_DIRECTION;
+        index -= direction_y[direction] * PLANNER_WIDTH + direction_x[direction];
+    }
+
+    // keep only the cells where the path has to change direction
+    int from = start_cell;
+    int position;
+    waypoint_count = 0;
+    waypoint_next = 0;
+    for(position = length - 1; position >= 0 && waypoint_count < PLANNER_MAX_WAYPOINTS; --position)
+    {
+        if(position == 0)
+        {
+            waypoint_cells[waypoint_count++] = open_nodes[0];
+        }
+        else if(!line_is_clear(from, open_nodes[position - 1], 0))
+        {
+            from = open_nodes[position];
+            waypoint_cells[waypoint_count++] = from;
+        }
+    }
+}
+
+bool is_occupied(int index)
+{
+    return occupied_cells[index >> 3] & (1 << (index & 7));
+}
+
+bool is_blocked(int index)
+{
+    int column = index % PLANNER_WIDTH;
+    int row = index / PLANNER_WIDTH;
+    int x, y;
+
+    // grow everything occupied by a cell so the robot can't be planned to pass right against it
+    for(y = row - 1; y <= row + 1; ++y)
+    {
+        for(x = column - 1; x <= column + 1; ++x)
+        {
+            if(x < 0 || y < 0 || x >= PLANNER_WIDTH || y >= PLANNER_HEIGHT)
+                continue;
+            if(is_occupied(y * PLANNER_WIDTH + x))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+bool is_blocked_now(int index)
+{
+    int first = index % PLANNER_WIDTH * PLANNER_SCALE - PLANNER_SCALE;
+    int row = index / PLANNER_WIDTH * PLANNER_SCALE - PLANNER_SCALE;
+    int x, y;
+
+    // the same area as is_blocked, but straight from the grid (cells off the grid are unknown, so never occupied)
+    for(y = row; y < row + PLANNER_SCALE * 3; ++y)
+    {
+        for(x = first; x < first + PLANNER_SCALE * 3; ++x)
+        {
+            if(grid_get_cell(x, y) == Grid_Cell_Occupied)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+bool line_is_clear(int from, int to, bool now)
+{
+    int column = from % PLANNER_WIDTH;
+    int row = from / PLANNER_WIDTH;
+    int endColumn = to % PLANNER_WIDTH;
+    int endRow = to / PLANNER_WIDTH;
+    int dx = abs(endColumn - column);
+    int dy = -abs(endRow - row);
+    int stepX = column < endColumn ? 1 : -1;
+    int stepY = row < endRow ? 1 : -1;
+    int error = dx + dy;
+
+    // Bresenham, skipping the cell the line starts in (the robot may have got close to something there already)
+    while(column != endColumn || row != endRow)
+    {
+        int error2 = error * 2;
+        if(error2 >= dy)
+        {
+            error += dy;
+            column += stepX;
+        }
+        if(error2 <= dx)
+        {
+            error += dx;
+            row += stepY;
+        }
+
+        int index = row * PLANNER_WIDTH + column;
+        if(index == goal_cell)
+            continue;
+        if(now ? is_blocked_now(index) && !is_blocked(index) : is_blocked(index))
+            return 0;
+    }
+    return 1;
+}
+
+bool path_is_clear(void)
+{
+    int from = start_cell;
+    int index;
+
+    // the same test the search's waypoints pass, so the path keeps the same distance from things (and keep out zones)
+    for(index = 0; index < waypoint_count; ++index)
+    {
+        if(!line_is_clear(from, waypoint_cells[index], 0))
+            return 0;
+        from = waypoint_cells[index];
+    }
+    return 1;
+}
+
+uint16_t heuristic(int index)
+{
+    int dx = abs(index % PLANNER_WIDTH - goal_cell % PLANNER_WIDTH);
+    int dy = abs(index / PLANNER_WIDTH - goal_cell / PLANNER_WIDTH);
+    int diagonal = dx < dy ? dx : dy;
+
+    // as many corner moves as possible, then straight the rest of the way
+    return diagonal * PLANNER_COST_DIAGONAL + (dx + dy - 2 * diagonal) * PLANNER_COST_STRAIGHT;
+}
+
+void open_push(uint16_t index, uint16_t score)
+{
+    // the list is full, so this node is left out (it can still be added if it's reached again more cheaply)
+    if(open_count == PLANNER_OPEN_MAX)
+    {
+        node_flags[index] &= ~PLANNER_REACHED;
+        return;
+    }
+
+    int position = open_count++;
+    while(position > 0)
+    {
+        int parent = (position - 1) >> 1;
+        if(open_scores[parent] <= score)
+            break;
+        open_nodes[position] = open_nodes[parent];
+        open_scores[position] = open_scores[parent];
+        position = parent;
+    }
+    open_nodes[position] = index;
+    open_scores[position] = score;
+}
+
+uint16_t open_pop(void)
+{
+    uint16_t top = open_nodes[0];
+    uint16_t index = open_nodes[--open_count];
+    uint16_t score = open_scores[open_count];
+    int position = 0;
+
+    // move the last node down from the top until it's in order
+    while(true)
+    {
+        int child = position * 2 + 1;
+        if(child >= open_count)
+            break;
+        if(child + 1 < open_count && open_scores[child + 1] < open_scores[child])
+            ++child;
+        if(score <= open_scores[child])
+            break;
+        open_nodes[position] = open_nodes[child];
+        open_scores[position] = open_scores[child];
+        position = child;
+    }
+    open_nodes[position] = index;
+    open_scores[position] = score;
+
+    return top;
+}
\ No newline at end of file
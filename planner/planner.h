@@ -0,0 +1,95 @@
+/*
+ * planner.h
+ * A* path planning over the occupancy grid, from the robot to the user or home
+ *
+ * The search runs on a coarser copy of the grid (PLANNER_SCALE x PLANNER_SCALE grid cells to a planner cell,
+ * a few thousand cells in all) with every occupied cell grown by one planner cell to allow for the size of the robot
+ * Unknown cells can be driven through, but cost more than free ones. Cells in a keep out zone (see geofence) count as occupied
+ *
+ * All of the memory is allocated up front: the per cell costs, and an open list with room for PLANNER_OPEN_MAX nodes
+ * The work is spread over calls to planner_step, each of which copies a few rows of the grid or expands a
+ * bounded number of nodes, so a search never holds up the control loop for long
+ *
+ * The path is returned as the few waypoints where it changes direction (cells with a clear line between them are skipped)
+ * A path from an earlier trip (see routes) can be followed instead of searching, it is checked against the grid as it is
+ * copied and the search only runs if something is in the way
+ *
+ * Created: 2026-10-19
+ */
+#ifndef PLANNERH
+#define PLANNERH
+
+#include "pico/stdlib.h"
+#include "../grid/grid.h"
+
+#define PLANNER_SCALE               2       // grid cells along each side of a planner cell (200mm)
+#define PLANNER_WIDTH               (GRID_WIDTH / PLANNER_SCALE)
+#define PLANNER_HEIGHT              (GRID_HEIGHT / PLANNER_SCALE)
+#define PLANNER_OPEN_MAX            1024    // most nodes the open list can hold at once
+#define PLANNER_MAX_WAYPOINTS       32      // most waypoints kept from a path (the rest is planned again once they're used up)
+#define PLANNER_ROWS_PER_STEP       8       // planner rows copied from the grid per step
+#define PLANNER_COST_STRAIGHT       10      // cost of moving to a side neighbour
+#define PLANNER_COST_DIAGONAL       14      // cost of moving to a corner neighbour
+#define PLANNER_COST_UNKNOWN        10      // extra cost of moving into a cell nothing is known about
+#define PLANNER_REPLAN_DISTANCE     300     // mm the goal can move before the path is planned again
+#define PLANNER_WAYPOINT_REACHED    200     // mm from a waypoint before moving on to the next
+
+/** \brief Where the planner is up to:
+ *  \ingroup planner
+ */
+typedef enum {
+    Planner_Status_Idle,        // nothing planned
+    Planner_Status_Searching,   // still working, keep calling planner_step
+    Planner_Status_Found,       // waypoints are ready
+    Planner_Status_NoPath       // the goal can't be reached (or the start/goal are off the grid)
+} Planner_Status;
+
+struct PlannerWaypoint {
+    long x; // mm
+    long y; // mm
+};
+
+// A path as the planner cells it changes direction in (the start cell isn't included, the last cell is the goal's)
+struct PlannerPath {
+    uint16_t start;
+    uint16_t goal;
+    uint8_t count;
+    uint16_t cells[PLANNER_MAX_WAYPOINTS];
+};
+
+// Forget the current path
+void planner_reset(void);
+
+// Start planning a path between two positions (in mm), replacing the current one
+void planner_start(long startX, long startY, long goalX, long goalY);
+
+// Start following a path from an earlier trip between two positions (in mm), replacing the current one
+// (the path's last cell is swapped for the goal's, and it's searched for as usual if the path is no longer clear)
+void planner_follow(long startX, long startY, long goalX, long goalY, const struct PlannerPath * path);
+
+// Do a bounded amount of the work of planning (copying rows of the grid, or expanding up to the given number of nodes)
+Planner_Status planner_step(int expansions);
+
+// Get where the planner is up to
+Planner_Status planner_get_status(void);
+
+// Check if a goal (in mm) is far enough away from the one the path was planned to that it should be planned again
+bool planner_goal_moved(long goalX, long goalY);
+
+// Check the rest of the path against the latest grid, returns 1 if something has shown up in the way
+bool planner_path_blocked(void);
+
+// Copy out the whole of the current path, returns 0 if there's none or it was cut short of the goal
+bool planner_get_path(struct PlannerPath * path);
+
+// Estimate the length (in mm) of a path between two positions, going the way the search does with nothing in the way
+long planner_estimate(long startX, long startY, long goalX, long goalY);
+
+// Find the planner cell a position (in mm) is in, returns 0 if the position is off the grid
+bool planner_cell_from_position(long x, long y, int * index);
+
+// Get the waypoint to head for from a position (in mm), moving past any that have been reached
+// returns 0 if there's no path (or the path has been used up and needs to be planned again)
+bool planner_next_waypoint(long x, long y, struct PlannerWaypoint * waypoint);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+/*
+ * pose.c
+ *
+ * Created: 2026-10-19
+ */
+#include "pico/stdlib.h"
+#include "../motors/motors.h"
+#include "pose.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+#define POSE_TRACK FIX16_FROM_FLOAT(WHEEL_TRACK * 100) // cm
+
+/// @brief Correct the heading from the direction travelled since the last anchor, if it was far enough and straight enough
+/// @param x The new UWB x position (in mm)
+/// @param y The new UWB y position (in mm)
+void correct_heading(long x, long y);
+
+/// @brief Start measuring the next straight line from the given position
+/// @param x The x position (in mm)
+/// @param y The y position (in mm)
+void reset_anchor(long x, long y);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+// position (in mm, fixed point so the small steps between UWB positions aren't lost to rounding)
+fix16_t pose_x = 0;
+fix16_t pose_y = 0;
+fix16_t pose_heading = 0;
+bool pose_set = 0;
+
+// where the current straight line started, and how it has been driven since
+long anchor_x = 0;
+long anchor_y = 0;
+fix16_t anchor_heading = 0;
+fix16_t anchor_turned = 0;  // largest change in heading since the anchor
+fix16_t anchor_distance = 0; // signed distance (in cm) driven since the anchor, negative if reversing
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void pose_init(fix16_t heading)
+{
+    pose_x = 0;
+    pose_y = 0;
+    pose_heading = fix16_wrap_angle(heading);
+    pose_set = 0;
+    reset_anchor(0, 0);
+}
+
+void pose_update_odometry(fix16_t left, fix16_t right, fix16_t dt)
+{
+    fix16_t distance = fix16_mul((left + right) >> 1, dt); // cm
+    fix16_t turn = fix16_div(fix16_mul(right - left, dt), POSE_TRACK);
+
+    // step along the average of the old and new heading
+    fix16_t midHeading = pose_heading + (turn >> 1);
+    pose_x += fix16_mul(distance * 10, fix16_cos(midHeading));
+    pose_y += fix16_mul(distance * 10, fix16_sin(midHeading));
+    pose_heading = fix16_wrap_angle(pose_heading + turn);
+
+    anchor_distance += distance;
+    fix16_t turned = fix16_wrap_angle(pose_heading - anchor_heading);
+    if(turned < 0)
+        turned = -turned;
+    if(turned > anchor_turned)
+        anchor_turned = turned;
+}
+
+void pose_update_position(long x, long y)
+{
+    if(!pose_set)
+    {
+        pose_set = 1;
+        reset_anchor(x, y);
+    }
+    else
+    {
+        correct_heading(x, y);
+    }
+
+    pose_x = FIX16_FROM_INT(x);
+    pose_y = FIX16_FROM_INT(y);
+}
+
+struct Pose pose_get(void)
+{
+    struct Pose pose;
+    pose.x = FIX16_TO_INT(pose_x);
+    pose.y = FIX16_TO_INT(pose_y);
+    pose.heading = pose_heading;
+    pose.set = pose_set;
+    return pose;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+void correct_heading(long x, long y)
+{
+    long dx = x - anchor_x;
+    long dy = y - anchor_y;
+
+    // not far enough yet to tell the direction apart from the UWB noise
+    if(dx * dx + dy * dy < (long) POSE_HEADING_MIN_TRAVEL * POSE_HEADING_MIN_TRAVEL)
+        return;
+
+    // only a straight line (as far as the wheels are concerned) says which way the robot is facing
+    if(anchor_turned <= POSE_HEADING_MAX_TURN && anchor_distance != 0)
+    {
+        fix16_t course = fix16_atan2(dy, dx);
+        if(anchor_distance < 0)
+            course += FIX16_PI;
+
+        fix16_t error = fix16_wrap_angle(course - pose_heading);
+        pose_heading = fix16_wrap_angle(pose_heading + fix16_mul(error, POSE_HEADING_CORRECTION));
+    }
+
+    reset_anchor(x, y);
+}
+
+void reset_anchor(long x, long y)
+{
+    anchor_x = x;
+    anchor_y = y;
+    anchor_heading = pose_heading;
+    anchor_turned = 0;
+    anchor_distance = 0;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+/*
+ * pose.h
+ * Estimate of where the robot is and which way it is facing
+ *
+ * The UWB position is used as is whenever a new one comes in, and the wheel speeds are integrated in between.
+ * The DWM1001 doesn't give a heading, so it is integrated from the difference in wheel speeds and
+ * corrected from the direction the UWB position moved whenever the robot has driven far enough in a straight line
+ *
+ * Coordinates are the UWB ones (mm), the heading is in radians counter-clockwise from the x axis
+ *
+ * Created: 2026-10-19
+ */
+#ifndef POSEH
+#define POSEH
+
+#include "pico/stdlib.h"
+#include "../fixed/fixed.h"
+
+#define POSE_HEADING_MIN_TRAVEL  500                       // mm between UWB positions before their direction is trusted (the DWM1001 is only good to ~100mm)
+#define POSE_HEADING_MAX_TURN    FIX16_FROM_FLOAT(0.15)    // rad the heading can change while travelling that far and still count as a straight line
+#define POSE_HEADING_CORRECTION  FIX16_FROM_FLOAT(0.25)    // fraction of the difference to the UWB direction applied for each correction
+
+struct Pose {
+    long x;             // mm
+    long y;             // mm
+    fix16_t heading;    // rad, counter-clockwise from the x axis (-pi to pi)
+    bool set;           // 1 once a UWB position has been received
+};
+
+// Start the estimate over, facing the given heading (the position is unknown until the first UWB position)
+void pose_init(fix16_t heading);
+
+// Integrate the measured wheel speeds (in cm/s, positive is forward) over the time since the last update (in s)
+void pose_update_odometry(fix16_t left, fix16_t right, fix16_t dt);
+
+// Take a new position (in mm) from the DWM1001
+void pose_update_position(long x, long y);
+
+// Get the current estimate
+struct Pose pose_get(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,167 @@
+/*
+ * routes.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "routes.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+/// @brief Find the route closest to going between two planner cells
+/// @param startCell The index of the planner cell the trip starts in
+/// @param goalCell The index of the planner cell the trip finishes in
+/// @param reversed Filled in with 1 if the route goes the other way
+/// @return The index of the route, -1 if none starts and finishes close enough
+int closest_route(int startCell, int goalCell, bool * reversed);
+
+/// @brief Get how far apart two planner cells are (the most of the columns or rows between them)
+/// @param first The index of the first planner cell
+/// @param second The index of the second planner cell
+/// @return The distance in planner cells
+int cell_distance(int first, int second);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+struct Routes routes;
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void routes_clear(void)
+{
+    memset(&routes, 0, sizeof(routes));
+}
+
+bool routes_load(const struct Routes * saved)
+{
+    int index;
+
+    routes_clear();
+    if(saved->count > ROUTES_MAX)
+        return 0;
+
+    // the grid may have been resized since they were saved
+    for(index = 0; index < saved->count; ++index)
+    {
+        const struct PlannerPath * path = &saved->routes[index].path;
+        if(path->count == 0 || path->count > PLANNER_MAX_WAYPOINTS || path->start >= PLANNER_WIDTH * PLANNER_HEIGHT
+            || path->goal >= PLANNER_WIDTH * PLANNER_HEIGHT || path->cells[path->count - 1] != path->goal)
+            return 0;
+    }
+
+    routes = *saved;
+    return 1;
+}
+
+const struct Routes * routes_get(void)
+{
+    return &routes;
+}
+
+bool routes_find(int startCell, int goalCell, struct PlannerPath * path)
+{
+    bool reversed;
+    int index = closest_route(startCell, goalCell, &reversed);
+
+    if(index == -1)
+        return 0;
+
+    const struct PlannerPath * route = &routes.routes[index].path;
+    routes.routes[index].used = ++routes.clock;
+
+    if(!reversed)
+    {
+        *path = *route;
+        return 1;
+    }
+
+    // back through the same cells, finishing where the route started
+    int position;
+    path->start = route->goal;
+    path->goal = route->start;
+    path->count = route->count;
+    for(position = 0; position < route->count - 1; ++position)
+        path->cells[position] = route->cells[route->count - 2 - position];
+    path->cells[route->count - 1] = route->start;
+    return 1;
+}
+
+void routes_record(const struct PlannerPath * path)
+{
+    bool reversed;
+    int index = closest_route(path->start, path->goal, &reversed);
+
+    if(path->count == 0 || path->count > PLANNER_MAX_WAYPOINTS)
+        return;
+
+    // a new trip takes a free place, or the place of the route that's gone unused the longest
+    if(index == -1 && routes.count < ROUTES_MAX)
+    {
+        index = routes.count++;
+    }
+    else if(index == -1)
+    {
+        int route;
+        index = 0;
+        for(route = 1; route < routes.count; ++route)
+        {
+            // (the clock wraps, so compare how long ago rather than the values)
+            if((uint16_t) (routes.clock - routes.routes[route].used) > (uint16_t) (routes.clock - routes.routes[index].used))
+                index = route;
+        }
+    }
+
+    routes.routes[index].path = *path;
+    routes.routes[index].used = ++routes.clock;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+int closest_route(int startCell, int goalCell, bool * reversed)
+{
+    int closest = -1;
+    int closestDistance = 0;
+    int index;
+
+    for(index = 0; index < routes.count; ++index)
+    {
+        const struct PlannerPath * path = &routes.routes[index].path;
+        int forwardStart = cell_distance(startCell, path->start);
+        int forwardGoal = cell_distance(goalCell, path->goal);
+        int backwardStart = cell_distance(startCell, path->goal);
+        int backwardGoal = cell_distance(goalCell, path->start);
+
+        if(forwardStart <= ROUTES_MATCH_CELLS && forwardGoal <= ROUTES_MATCH_CELLS
+            && (closest == -1 || forwardStart + forwardGoal < closestDistance))
+        {
+            closest = index;
+            closestDistance = forwardStart + forwardGoal;
+            *reversed = 0;
+        }
+        if(backwardStart <= ROUTES_MATCH_CELLS && backwardGoal <= ROUTES_MATCH_CELLS
+            && (closest == -1 || backwardStart + backwardGoal < closestDistance))
+        {
+            closest = index;
+            closestDistance = backwardStart + backwardGoal;
+            *reversed = 1;
+        }
+    }
+    return closest;
+}
+
+int cell_distance(int first, int second)
+{
+    int columns = abs(first % PLANNER_WIDTH - second % PLANNER_WIDTH);
+    int rows = abs(first / PLANNER_WIDTH - second / PLANNER_WIDTH);
+    return columns > rows ? columns : rows;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+/*
+ * routes.h
+ * Paths the robot has driven before (home to the bedroom, the couch to home, etc), so repeat trips can skip the search
+ *
+ * Each route is the planner's path from a trip that arrived, kept as the cells it changes direction in and keyed by
+ * the cells it started and finished in. A route can be used for a trip starting and finishing within ROUTES_MATCH_CELLS
+ * planner cells of its own (either way round), and the planner checks it is still clear before following it
+ *
+ * Created: 2026-10-19
+ */
+#ifndef ROUTESH
+#define ROUTESH
+
+#include "pico/stdlib.h"
+#include "../planner/planner.h"
+
+#define ROUTES_MAX          8       // routes remembered (the one used least recently is replaced)
+#define ROUTES_MATCH_CELLS  2       // planner cells the start and the goal may each be from a route's (400mm)
+#define ROUTES_VERSION      1       // format of struct Routes when it's saved
+
+struct Route {
+    uint16_t used;              // when it was last recorded or found (from the routes' clock)
+    struct PlannerPath path;
+};
+
+struct Routes {
+    uint8_t count;
+    uint16_t clock;             // counts up each time a route is recorded or found
+    struct Route routes[ROUTES_MAX];
+};
+
+// Forget all of the routes
+void routes_clear(void);
+
+// Replace the routes (e.g. with those saved), returns 0 if they aren't valid (and the routes are cleared)
+bool routes_load(const struct Routes * routes);
+
+// Get the routes that are remembered
+const struct Routes * routes_get(void);
+
+// Find the route closest to going between two planner cells, and copy it out facing the right way
+// returns 0 if no route starts and finishes close enough
+bool routes_find(int startCell, int goalCell, struct PlannerPath * path);
+
+// Remember a path that got the robot to its goal, replacing the route it was close enough to use (if there was one)
+void routes_record(const struct PlannerPath * path);
+
+#endif
\ No newline at end of file
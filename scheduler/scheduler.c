@@ -0,0 +1,226 @@
+/*
+ * scheduler.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "scheduler.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+/// @brief Put a task into the slot for its deadline
+/// @param scheduler The scheduler
+/// @param index The index of the task
+void link_task(struct Scheduler * scheduler, int index);
+
+/// @brief Take a task out of its slot
+/// @param scheduler The scheduler
+/// @param index The index of the task
+void unlink_task(struct Scheduler * scheduler, int index);
+
+/// @brief Find the task an id refers to, if it is still active
+/// @param scheduler The scheduler
+/// @param id The id returned when the task was added
+/// @return The index of the task, -1 if it has finished or been cancelled
+int find_task(struct Scheduler * scheduler, int id);
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void scheduler_init(struct Scheduler * scheduler)
+{
+    int index;
+
+    for(index = 0; index < SCHEDULER_MAX_TASKS; ++index)
+    {
+        scheduler->tasks[index].active = 0;
+        scheduler->tasks[index].generation = 0;
+    }
+    for(index = 0; index < SCHEDULER_SLOTS; ++index)
+        scheduler->slots[index] = -1;
+
+    scheduler->tick = time_us_64() / SCHEDULER_TICK;
+}
+
+int scheduler_add(struct Scheduler * scheduler, const char * name, uint64_t deadline, uint32_t period, SchedulerCallback callback, void * data)
+{
+    int index;
+
+    for(index = 0; index < SCHEDULER_MAX_TASKS; ++index)
+    {
+        struct SchedulerTask * task = &scheduler->tasks[index];
+        if(task->active)
+            continue;
+
+        task->name = name;
+        task->callback = callback;
+        task->data = data;
+        task->deadline = deadline;
+        task->period = period;
+        task->runs = 0;
+        task->misses = 0;
+        task->late_max = 0;
+        task->active = 1;
+        ++task->generation;
+        link_task(scheduler, index);
+
+        return (task->generation << 8) | index;
+    }
+
+    return -1;
+}
+
+bool scheduler_cancel(struct Scheduler * scheduler, int id)
+{
+    int index = find_task(scheduler, id);
+    if(index < 0)
+        return 0;
+
+    unlink_task(scheduler, index);
+    scheduler->tasks[index].active = 0;
+    return 1;
+}
+
+bool scheduler_pending(struct Scheduler * scheduler, int id)
+{
+    return find_task(scheduler, id) >= 0;
+}
+
+int scheduler_run(struct Scheduler * scheduler)
+{
+    uint64_t now = time_us_64();
+    uint64_t nowTick = now / SCHEDULER_TICK;
+    uint64_t tick = scheduler->tick;
+    int16_t due[SCHEDULER_MAX_TASKS];
+    uint8_t generations[SCHEDULER_MAX_TASKS];
+    int count = 0, ran = 0, index, position;
+
+    // only the slots for the ticks that have passed (the last one again, since it may have had more added to it), at most once around
+    if(nowTick - tick >= SCHEDULER_SLOTS)
+        tick = nowTick - SCHEDULER_SLOTS + 1;
+
+    for(; tick <= nowTick; ++tick)
+    {
+        for(index = scheduler->slots[tick & (SCHEDULER_SLOTS - 1)]; index >= 0; index = scheduler->tasks[index].next)
+        {
+            if(scheduler->tasks[index].deadline > now)
+                continue;
+
+            // keep them in deadline order
+            for(position = count++; position > 0 && scheduler->tasks[due[position - 1]].deadline > scheduler->tasks[index].deadline; --position)
+            {
+                due[position] = due[position - 1];
+                generations[position] = generations[position - 1];
+            }
+            due[position] = index;
+            generations[position] = scheduler->tasks[index].generation;
+        }
+    }
+    scheduler->tick = nowTick;
+
+    for(position = 0; position < count; ++position)
+    {
+        struct SchedulerTask * task = &scheduler->tasks[due[position]];
+
+        // an earlier task may have cancelled (or replaced) this one
+        if(!task->active || task->generation != generations[position])
+            continue;
+
+        uint64_t start = time_us_64();
+        uint64_t late = start - task->deadline;
+        if(late > task->late_max)
+            task->late_max = late > UINT32_MAX ? UINT32_MAX : late;
+        if(late > SCHEDULER_MISS_TOLERANCE)
+            ++task->misses;
+        ++task->runs;
+
+        // set up the next run before calling it, so the callback can cancel it
+        unlink_task(scheduler, due[position]);
+        if(task->period > 0)
+        {
+            // fell behind by whole periods, skip them rather than running it several times in a row
+            uint64_t skipped = late / task->period;
+            task->misses += skipped;
+            task->deadline += (skipped + 1) * task->period;
+            link_task(scheduler, due[position]);
+        }
+        else
+        {
+            task->active = 0;
+        }
+
+        task->callback(task->data);
+        ++ran;
+    }
+
+    return ran;
+}
+
+void scheduler_print_stats(struct Scheduler * scheduler)
+{
+    int index;
+
+    for(index = 0; index < SCHEDULER_MAX_TASKS; ++index)
+    {
+        struct SchedulerTask * task = &scheduler->tasks[index];
+        if(task->active)
+            printf("\ntask %s: %d runs, %d missed, latest %d us", task->name, task->runs, task->misses, task->late_max);
+    }
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+void link_task(struct Scheduler * scheduler, int index)
+{
+    // a deadline that has already passed goes in the slot that will be looked at next
+    uint64_t tick = scheduler->tasks[index].deadline / SCHEDULER_TICK;
+    if(tick < scheduler->tick)
+        tick = scheduler->tick;
+
+    int slot = tick & (SCHEDULER_SLOTS - 1);
+    scheduler->tasks[index].next = scheduler->slots[slot];
+    scheduler->slots[slot] = index;
+}
+
+void unlink_task(struct Scheduler * scheduler, int index)
+{
+    uint64_t tick = scheduler->tasks[index].deadline / SCHEDULER_TICK;
+    int slot;
+
+    // the task may have gone in the next slot to be looked at, rather than the one for its deadline
+    for(slot = 0; slot < SCHEDULER_SLOTS; ++slot)
+    {
+        int16_t * link = &scheduler->slots[(tick + slot) & (SCHEDULER_SLOTS - 1)];
+        while(*link >= 0)
+        {
+            if(*link == index)
+            {
+                *link = scheduler->tasks[index].next;
+                return;
+            }
+            link = &scheduler->tasks[*link].next;
+        }
+    }
+}
+
+int find_task(struct Scheduler * scheduler, int id)
+{
+    if(id < 0)
+        return -1;
+
+    int index = id & 0xFF;
+    if(index >= SCHEDULER_MAX_TASKS)
+        return -1;
+
+    struct SchedulerTask * task = &scheduler->tasks[index];
+    if(!task->active || task->generation != ((id >> 8) & 0xFF))
+        return -1;
+
+    return index;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+/*
+ * scheduler.h
+ * Cooperative scheduler for periodic and one-shot work, run from each core's main loop
+ *
+ * Tasks are kept in a hashed timer wheel: SCHEDULER_SLOTS slots of SCHEDULER_TICK us each, a task sitting in the
+ * slot its deadline falls in (deadlines more than a turn of the wheel away share the slot, and are skipped until due)
+ * A run only looks at the slots for the ticks that have passed since the last run, and runs what's due in deadline order
+ * Times are 64 bit us (time_us_64), so they never wrap
+ *
+ * Each task keeps how many times it has run, how many runs it missed (started more than SCHEDULER_MISS_TOLERANCE late,
+ * or a whole period skipped) and the latest it has started
+ *
+ * Created: 2026-10-19
+ */
+#ifndef SCHEDULERH
+#define SCHEDULERH
+
+#include "pico/stdlib.h"
+
+#define SCHEDULER_SLOTS             64      // slots in the wheel (must be a power of 2)
+#define SCHEDULER_TICK              1000    // us covered by each slot
+#define SCHEDULER_MAX_TASKS         16      // most tasks a scheduler can hold at once
+#define SCHEDULER_MISS_TOLERANCE    2000    // us a task can start late before it counts as a miss
+
+typedef void (*SchedulerCallback)(void * data);
+
+struct SchedulerTask {
+    const char * name;          // for the stats
+    SchedulerCallback callback;
+    void * data;                // passed to the callback
+    uint64_t deadline;          // us, when it's next due
+    uint32_t period;            // us between runs, 0 if it only runs once
+    uint32_t runs;
+    uint32_t misses;
+    uint32_t late_max;          // us, latest it has started
+    int16_t next;               // next task in the same slot (-1 if it's the last)
+    uint8_t generation;         // changes each time the task is reused, so an old id can't cancel the new task
+    bool active;
+};
+
+struct Scheduler {
+    struct SchedulerTask tasks[SCHEDULER_MAX_TASKS];
+    int16_t slots[SCHEDULER_SLOTS]; // first task in each slot (-1 if empty)
+    uint64_t tick;                  // the tick it last ran up to
+};
+
+// Set up a scheduler with no tasks
+void scheduler_init(struct Scheduler * scheduler);
+
+// Add a task that runs at the deadline (in us), and every period (in us) after that (0 to only run once)
+// returns an id for the task (-1 if there's no room for it)
+int scheduler_add(struct Scheduler * scheduler, const char * name, uint64_t deadline, uint32_t period, SchedulerCallback callback, void * data);
+
+// Remove a task before it runs again, returns 0 if it had already finished (or been cancelled)
+bool scheduler_cancel(struct Scheduler * scheduler, int id);
+
+// Check if a task is still waiting to run
+bool scheduler_pending(struct Scheduler * scheduler, int id);
+
+// Run every task that is due, returns how many were run
+int scheduler_run(struct Scheduler * scheduler);
+
+// Print the runs, misses and latest start of each task
+void scheduler_print_stats(struct Scheduler * scheduler);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,255 @@
+/*
+ * store.c
+ *
+ * Created: 2026-10-19
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "store.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+#define STORE_MAGIC 0x31545341 // "AST1"
+
+// Layout of the header at the start of each slot
+struct StoreHeader {
+    uint32_t magic;
+    uint8_t record;
+    uint8_t version;
+    uint16_t reserved;
+    uint32_t sequence;      // one more than the copy it replaced
+    uint32_t length;        // bytes of data
+    uint32_t crc;           // over the header (up to here) and the data
+};
+
+/// @brief Get where a slot of a record is in flash
+/// @param record Which record the slot belongs to
+/// @param slot Which of the record's slots
+/// @return The offset of the slot from the start of flash
+uint32_t slot_offset(Store_Record record, int slot);
+
+/// @brief Get the header of a slot (read straight from flash)
+/// @param record Which record the slot belongs to
+/// @param slot Which of the record's slots
+/// @return The header
+const struct StoreHeader * slot_header(Store_Record record, int slot);
+
+/// @brief Get the most data one of a record's slots can hold
+/// @param record The record
+/// @return The size in bytes
+size_t slot_capacity(Store_Record record);
+
+/// @brief Check the header and data of a slot are complete and belong to the record
+/// @param record Which record the slot belongs to
+/// @param slot Which of the record's slots
+/// @return 1 if the slot holds a valid copy of the record
+bool slot_valid(Store_Record record, int slot);
+
+/// @brief Continue a CRC32 (reflected, polynomial 0xEDB88320) over more bytes
+/// @param crc The CRC so far (start with 0)
+/// @param data The bytes to add
+/// @param length How many bytes to add
+/// @return The CRC including the bytes
+uint32_t crc32(uint32_t crc, const uint8_t * data, size_t length);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+// How much flash each record gets, laid out back from the end of flash in order
+// (so a new record added at the end doesn't move the ones already saved)
+const struct {
+    uint8_t sectors;    // per slot
+    uint8_t slots;
+} store_areas[Store_Record_Count] = {
+    { 1, 4 },           // Store_Record_MotorCalibration (the motor calibration's old sector is its last slot)
+    { 1, 4 },           // Store_Record_WeightTare
+    { 1, 4 },           // Store_Record_Home
+    { 9, 3 },           // Store_Record_Map (32kB worst case plus the header page)
+    { 1, 4 },           // Store_Record_Geofence
+    { 1, 4 }            // Store_Record_Routes
+};
+
+// Where each record's area starts, from the start of flash
+uint32_t store_offsets[Store_Record_Count];
+
+// The slot holding the latest valid copy of each record (-1 if none), and the highest sequence seen in its area
+int store_latest[Store_Record_Count];
+uint32_t store_sequence[Store_Record_Count];
+
+// CRC32 of each nibble, so the CRC only needs a small table
+const uint32_t crc_table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void store_init(void)
+{
+    uint32_t offset = PICO_FLASH_SIZE_BYTES;
+    int record, slot;
+
+    for(record = 0; record < Store_Record_Count; ++record)
+    {
+        offset -= store_areas[record].sectors * store_areas[record].slots * FLASH_SECTOR_SIZE;
+        store_offsets[record] = offset;
+    }
+
+    for(record = 0; record < Store_Record_Count; ++record)
+    {
+        uint32_t latestSequence = 0;
+
+        store_latest[record] = -1;
+        store_sequence[record] = 0;
+
+        for(slot = 0; slot < store_areas[record].slots; ++slot)
+        {
+            const struct StoreHeader * header = slot_header(record, slot);
+            if(header->magic != STORE_MAGIC || header->record != record)
+                continue;
+
+            // a newer copy that is damaged still counts for the sequence, so the next save goes after it
+            if(header->sequence >= store_sequence[record])
+                store_sequence[record] = header->sequence;
+
+            // but the copy to use is the newest one that is whole (whatever order the slots are in)
+            if(slot_valid(record, slot) && (store_latest[record] < 0 || header->sequence >= latestSequence))
+            {
+                store_latest[record] = slot;
+                latestSequence = header->sequence;
+            }
+        }
+    }
+}
+
+const uint8_t * store_find(Store_Record record, uint8_t version, size_t * length)
+{
+    int slot = store_latest[record];
+    if(slot < 0)
+        return NULL;
+
+    const struct StoreHeader * header = slot_header(record, slot);
+    if(header->version != version)
+        return NULL;
+
+    *length = header->length;
+    return (const uint8_t *) (XIP_BASE + slot_offset(record, slot) + FLASH_PAGE_SIZE);
+}
+
+bool store_load(Store_Record record, uint8_t version, void * data, size_t size)
+{
+    size_t length;
+    const uint8_t * stored = store_find(record, version, &length);
+
+    if(stored == NULL || length != size)
+        return 0;
+
+    memcpy(data, stored, size);
+    return 1;
+}
+
+bool store_save(Store_Record record, uint8_t version, const void * data, size_t length)
+{
+    static uint8_t page[FLASH_PAGE_SIZE];
+    struct StoreHeader * header = (struct StoreHeader *) page;
+    size_t whole = length - length % FLASH_PAGE_SIZE;
+    // only the sectors the header and data take are erased (what's left in the rest of the slot is never read,
+    // the header's length and CRC only cover this copy)
+    size_t erase = (FLASH_PAGE_SIZE + length + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE;
+    uint32_t interrupts;
+
+    if(length > slot_capacity(record))
+        return 0;
+
+    int slot = (store_latest[record] + 1) % store_areas[record].slots;
+    uint32_t offset = slot_offset(record, slot);
+
+    memset(page, 0xFF, sizeof(page));
+    header->magic = STORE_MAGIC;
+    header->record = record;
+    header->version = version;
+    header->reserved = 0;
+    header->sequence = store_sequence[record] + 1;
+    header->length = length;
+    header->crc = crc32(crc32(0, page, offsetof(struct StoreHeader, crc)), data, length);
+
+    // stop core 1 (if it's running) somewhere it isn't reading flash, and keep our own interrupts out
+    bool lockout = multicore_lockout_victim_is_initialized(1);
+    if(lockout)
+        multicore_lockout_start_blocking();
+    interrupts = save_and_disable_interrupts();
+
+    flash_range_erase(offset, erase);
+    // the whole pages of data can go straight from the caller, the rest is padded out to a page
+    if(whole > 0)
+        flash_range_program(offset + FLASH_PAGE_SIZE, data, whole);
+    if(whole < length)
+    {
+        static uint8_t tail[FLASH_PAGE_SIZE];
+        memset(tail, 0xFF, sizeof(tail));
+        memcpy(tail, (const uint8_t *) data + whole, length - whole);
+        flash_range_program(offset + FLASH_PAGE_SIZE + whole, tail, sizeof(tail));
+    }
+    // and the header last, once the data is all there
+    flash_range_program(offset, page, sizeof(page));
+
+    restore_interrupts(interrupts);
+    if(lockout)
+        multicore_lockout_end_blocking();
+
+    store_latest[record] = slot;
+    store_sequence[record] = header->sequence;
+    return 1;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+uint32_t slot_offset(Store_Record record, int slot)
+{
+    return store_offsets[record] + slot * store_areas[record].sectors * FLASH_SECTOR_SIZE;
+}
+
+const struct StoreHeader * slot_header(Store_Record record, int slot)
+{
+    return (const struct StoreHeader *) (XIP_BASE + slot_offset(record, slot));
+}
+
+size_t slot_capacity(Store_Record record)
+{
+    return store_areas[record].sectors * FLASH_SECTOR_SIZE - FLASH_PAGE_SIZE;
+}
+
+bool slot_valid(Store_Record record, int slot)
+{
+    const struct StoreHeader * header = slot_header(record, slot);
+    const uint8_t * data = (const uint8_t *) header + FLASH_PAGE_SIZE;
+
+    if(header->length > slot_capacity(record))
+        return 0;
+
+    return header->crc == crc32(crc32(0, (const uint8_t *) header, offsetof(struct StoreHeader, crc)), data, header->length);
+}
+
+uint32_t crc32(uint32_t crc, const uint8_t * data, size_t length)
+{
+    crc = ~crc;
+    while(length--)
+    {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ crc_table[crc & 0x0F];
+        crc = (crc >> 4) ^ crc_table[crc & 0x0F];
+    }
+    return ~crc;
+}
\ No newline at end of file
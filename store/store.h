@@ -0,0 +1,50 @@
+/*
+ * store.h
+ * Records kept in on-board flash so they survive a reboot (maps, calibrations, etc)
+ *
+ * The store takes the sectors at the end of flash, well clear of the program. Each record has its own area,
+ * split into a few slots that are written in turn so no one sector takes every erase. A save goes into the slot
+ * after the latest one, and the latest valid slot is the one with the highest sequence number
+ *
+ * Each slot starts with a page holding the header (record, format version, sequence, length and a CRC32 over
+ * the header and the data) and the data follows from the next page. The data is programmed before the header,
+ * so a save cut short leaves a slot without a header and the previous one is still used
+ *
+ * Core 1 must have called multicore_lockout_victim_init before anything is saved while it is running,
+ * since nothing can run from flash while it's being written
+ *
+ * Created: 2026-10-19
+ */
+#ifndef STOREH
+#define STOREH
+
+#include "pico/stdlib.h"
+
+/** \brief Selector for what a record holds:
+ *  \ingroup store
+ */
+typedef enum {
+    Store_Record_MotorCalibration,
+    Store_Record_WeightTare,
+    Store_Record_Home,
+    Store_Record_Map,
+    Store_Record_Geofence,
+    Store_Record_Routes,
+    Store_Record_Count
+} Store_Record;
+
+// Find the latest copy of every record (must be called before anything is loaded or saved)
+void store_init(void);
+
+// Get the data of the latest copy of the record straight from flash, NULL if there's none with the version
+// (the length is filled in with the number of bytes)
+const uint8_t * store_find(Store_Record record, uint8_t version, size_t * length);
+
+// Copy the latest copy of the record into the data, returns 0 if there's none with the version and size
+bool store_load(Store_Record record, uint8_t version, void * data, size_t size);
+
+// Save a new copy of the record (the data must be in RAM), returns 0 if it is too big for the record's slots
+// Interrupts are off for the erase (~50ms for each sector the copy takes), so only save while the robot is stopped
+bool store_save(Store_Record record, uint8_t version, const void * data, size_t length);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+/*
+ * tour.c
+ *
+ * Created: 2026-10-19
+ */
+#include <string.h>
+#include "pico/stdlib.h"
+#include "tour.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+// The start is the first position, then the stops
+#define TOUR_POSITIONS (TOUR_MAX_STOPS + 1)
+
+/// @brief Put the stops in order by always going to the nearest one left
+/// @param count The number of stops
+/// @param order Filled in with the order to visit the positions (the start first)
+void nearest_neighbour(int count, uint8_t * order);
+
+/// @brief Reverse runs of stops while it makes the trip shorter
+/// @param count The number of stops
+/// @param order The order to visit the positions (the start first), improved in place
+void two_opt(int count, uint8_t * order);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+// cost between each pair of positions, filled in by tour_plan
+long tour_costs[TOUR_POSITIONS][TOUR_POSITIONS];
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+long tour_plan(struct Tour * tour, long startX, long startY, TourCost cost)
+{
+    struct TourStop stops[TOUR_MAX_STOPS];
+    uint8_t order[TOUR_POSITIONS];
+    long total = 0;
+    int from, to;
+
+    tour->next = 0;
+    if(tour->count > TOUR_MAX_STOPS)
+        tour->count = TOUR_MAX_STOPS;
+    if(tour->count == 0)
+        return 0;
+
+    // the costs are the same both ways, so each pair only has to be worked out once
+    for(from = 0; from <= tour->count; ++from)
+    {
+        tour_costs[from][from] = 0;
+        for(to = from + 1; to <= tour->count; ++to)
+        {
+            long fromX = from == 0 ? startX : tour->stops[from - 1].x;
+            long fromY = from == 0 ? startY : tour->stops[from - 1].y;
+            tour_costs[from][to] = cost(fromX, fromY, tour->stops[to - 1].x, tour->stops[to - 1].y);
+            tour_costs[to][from] = tour_costs[from][to];
+        }
+    }
+
+    nearest_neighbour(tour->count, order);
+    two_opt(tour->count, order);
+
+    memcpy(stops, tour->stops, sizeof(stops));
+    for(to = 1; to <= tour->count; ++to)
+    {
+        tour->stops[to - 1] = stops[order[to] - 1];
+        total += tour_costs[order[to - 1]][order[to]];
+    }
+    // and back to the start
+    return total + tour_costs[order[tour->count]][0];
+}
+
+bool tour_current(const struct Tour * tour, struct TourStop * stop)
+{
+    if(tour->next >= tour->count)
+        return 0;
+
+    *stop = tour->stops[tour->next];
+    return 1;
+}
+
+bool tour_advance(struct Tour * tour)
+{
+    if(tour->next < tour->count)
+        ++tour->next;
+    return tour->next < tour->count;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+void nearest_neighbour(int count, uint8_t * order)
+{
+    bool visited[TOUR_POSITIONS] = {0};
+    int position, candidate;
+
+    order[0] = 0;
+    for(position = 1; position <= count; ++position)
+    {
+        int last = order[position - 1];
+        int nearest = -1;
+
+        for(candidate = 1; candidate <= count; ++candidate)
+        {
+            if(!visited[candidate] && (nearest == -1 || tour_costs[last][candidate] < tour_costs[last][nearest]))
+                nearest = candidate;
+        }
+        visited[nearest] = 1;
+        order[position] = nearest;
+    }
+}
+
+void two_opt(int count, uint8_t * order)
+{
+    bool improved = 1;
+    int first, last;
+
+    // every change makes the trip strictly shorter, so this always finishes
+    while(improved)
+    {
+        improved = 0;
+        for(first = 1; first < count; ++first)
+        {
+            for(last = first + 1; last <= count; ++last)
+            {
+                // (the trip goes back to the start after the last stop)
+                int before = order[first - 1];
+                int after = last == count ? 0 : order[last + 1];
+                long current = tour_costs[before][order[first]] + tour_costs[order[last]][after];
+                long swapped = tour_costs[before][order[last]] + tour_costs[order[first]][after];
+
+                if(swapped < current)
+                {
+                    // visit the stops from first to last the other way round
+                    int low, high;
+                    for(low = first, high = last; low < high; ++low, --high)
+                    {
+                        uint8_t stop = order[low];
+                        order[low] = order[high];
+                        order[high] = stop;
+                    }
+                    improved = 1;
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+/*
+ * tour.h
+ * The order to make several deliveries in, as one trip from home and back
+ *
+ * The stops are put in order by going to the nearest one not yet visited each time, then the order is improved with
+ * 2-opt (reversing any run of stops that makes the trip shorter) until nothing more can be gained. It isn't always the
+ * shortest trip, but it is usually close, and with so few stops it takes a fraction of a millisecond
+ * The cost of going between two positions is left to the caller (e.g. the planner's estimate)
+ *
+ * Created: 2026-10-19
+ */
+#ifndef TOURH
+#define TOURH
+
+#include "pico/stdlib.h"
+
+#define TOUR_MAX_STOPS  8
+
+struct TourStop {
+    int scheduleId;
+    long x;     // mm
+    long y;     // mm
+};
+
+struct Tour {
+    uint8_t count;
+    uint8_t next;       // the stop being headed for (count once they've all been visited)
+    struct TourStop stops[TOUR_MAX_STOPS];
+};
+
+// Cost of going between two positions (in mm), it must be the same both ways
+typedef long (*TourCost)(long fromX, long fromY, long toX, long toY);
+
+// Put the stops in the order to visit them, starting and finishing at a position (in mm), returns the cost of the whole trip
+long tour_plan(struct Tour * tour, long startX, long startY, TourCost cost);
+
+// Get the stop being headed for, returns 0 once they've all been visited
+bool tour_current(const struct Tour * tour, struct TourStop * stop);
+
+// Move on to the next stop, returns 0 if there are none left
+bool tour_advance(struct Tour * tour);
+
+#endif
\ No newline at end of file
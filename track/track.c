@@ -0,0 +1,132 @@
+/*
+ * track.c
+ *
+ * Created: 2026-10-19
+ */
+#include "pico/stdlib.h"
+#include "track.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+/// @brief Fit a straight line through the recent fixes to find the velocity
+/// @param track The track
+void fit_velocity(struct Track * track);
+
+/// @brief Limit the velocity to TRACK_MAX_SPEED, keeping its direction
+/// @param track The track
+void limit_velocity(struct Track * track);
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void track_reset(struct Track * track)
+{
+    track->count = 0;
+    track->latest = 0;
+    track->velocityX = 0;
+    track->velocityY = 0;
+}
+
+void track_add_fix(struct Track * track, long x, long y, uint64_t time)
+{
+    if(track->count > 0)
+        track->latest = (track->latest + 1) % TRACK_FIXES;
+    if(track->count < TRACK_FIXES)
+        ++track->count;
+
+    track->fixes[track->latest].x = x;
+    track->fixes[track->latest].y = y;
+    track->fixes[track->latest].time = time;
+
+    fit_velocity(track);
+}
+
+bool track_predict(struct Track * track, uint64_t time, long * x, long * y)
+{
+    struct TrackFix * latest = &track->fixes[track->latest];
+    long elapsed;
+
+    if(track->count == 0)
+        return 0;
+
+    elapsed = time > latest->time ? (long) ((time - latest->time) / 1000) : 0;
+    if(elapsed > TRACK_MAX_PREDICTION)
+        elapsed = TRACK_MAX_PREDICTION;
+
+    *x = latest->x + (long) (((int64_t) track->velocityX * elapsed / 1000) >> 16);
+    *y = latest->y + (long) (((int64_t) track->velocityY * elapsed / 1000) >> 16);
+    return 1;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+void fit_velocity(struct Track * track)
+{
+    struct TrackFix * latest = &track->fixes[track->latest];
+    long times[TRACK_FIXES];
+    int used = 0;
+    int fix;
+    int64_t sumT = 0, sumX = 0, sumY = 0;
+
+    // times are ms before the latest fix (so they stay small), positions relative to the latest fix
+    for(fix = 0; fix < track->count; ++fix)
+    {
+        struct TrackFix * current = &track->fixes[(track->latest - fix + TRACK_FIXES) % TRACK_FIXES];
+        long age = (long) ((latest->time - current->time) / 1000);
+        if(age > TRACK_WINDOW)
+            break;
+
+        times[used++] = -age;
+        sumT += -age;
+        sumX += current->x - latest->x;
+        sumY += current->y - latest->y;
+    }
+
+    // slope = sum((t - mean t)(x - mean x)) / sum((t - mean t)^2), kept as sums scaled by the count to stay in integers
+    int64_t covarianceX = 0, covarianceY = 0, variance = 0;
+    for(fix = 0; fix < used; ++fix)
+    {
+        struct TrackFix * current = &track->fixes[(track->latest - fix + TRACK_FIXES) % TRACK_FIXES];
+        int64_t t = times[fix] * used - sumT;
+        covarianceX += t * ((current->x - latest->x) * used - sumX);
+        covarianceY += t * ((current->y - latest->y) * used - sumY);
+        variance += t * t;
+    }
+
+    // a single fix (or several at the same time) doesn't say anything about the velocity
+    if(variance == 0)
+    {
+        track->velocityX = 0;
+        track->velocityY = 0;
+        return;
+    }
+
+    // mm per ms ==> mm/s, in fixed point (fixes very close together can give anything, so limit it before it's narrowed)
+    int64_t limit = FIX16_FROM_INT(TRACK_MAX_SPEED);
+    int64_t velocityX = (covarianceX * 1000 << 16) / variance;
+    int64_t velocityY = (covarianceY * 1000 << 16) / variance;
+    track->velocityX = velocityX > limit ? limit : velocityX < -limit ? -limit : velocityX;
+    track->velocityY = velocityY > limit ? limit : velocityY < -limit ? -limit : velocityY;
+    limit_velocity(track);
+}
+
+void limit_velocity(struct Track * track)
+{
+    // in m/s, so the square still fits
+    fix16_t velocityX = track->velocityX / 1000;
+    fix16_t velocityY = track->velocityY / 1000;
+    fix16_t speed = fix16_sqrt(fix16_mul(velocityX, velocityX) + fix16_mul(velocityY, velocityY));
+
+    if(speed <= FIX16_FROM_FLOAT(TRACK_MAX_SPEED / 1000.0))
+        return;
+
+    // scale both down together by max / speed
+    fix16_t scale = fix16_div(FIX16_FROM_FLOAT(TRACK_MAX_SPEED / 1000.0), speed);
+    track->velocityX = fix16_mul(track->velocityX, scale);
+    track->velocityY = fix16_mul(track->velocityY, scale);
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+/*
+ * track.h
+ * Following something that moves (e.g. the user) from occasional position fixes
+ *
+ * The last few fixes are kept with when they were taken, and a straight line fitted through them (least squares)
+ * gives the velocity. The position can then be predicted for any time, up to TRACK_MAX_PREDICTION past the last fix
+ *
+ * Created: 2026-10-19
+ */
+#ifndef TRACKH
+#define TRACKH
+
+#include "pico/stdlib.h"
+#include "../fixed/fixed.h"
+
+#define TRACK_FIXES             5       // fixes kept for the velocity fit
+#define TRACK_WINDOW            3000    // ms, fixes older than this (compared to the latest) aren't used in the fit
+#define TRACK_MAX_PREDICTION    2000    // ms past the last fix a position will be predicted for (it's held there after)
+#define TRACK_MAX_SPEED         2000    // mm/s, fastest the velocity is allowed to be (a brisk walk)
+
+struct TrackFix {
+    long x;         // mm
+    long y;         // mm
+    uint64_t time;  // us
+};
+
+struct Track {
+    struct TrackFix fixes[TRACK_FIXES]; // ring of the latest fixes
+    int count;                          // fixes in the ring
+    int latest;                         // index of the latest fix
+    fix16_t velocityX;                  // mm/s
+    fix16_t velocityY;                  // mm/s
+};
+
+// Forget all of the fixes
+void track_reset(struct Track * track);
+
+// Add a fix (in mm) taken at a time (in us), updating the velocity
+void track_add_fix(struct Track * track, long x, long y, uint64_t time);
+
+// Predict the position (in mm) at a time (in us), returns 0 if there haven't been any fixes
+bool track_predict(struct Track * track, uint64_t time, long * x, long * y);
+
+#endif
\ No newline at end of file
@@ -7,13 +7,14 @@
 #include <stdio.h>
 #include "pico/stdlib.h"
 #include "ultrasonic.h"
+#include "../fixed/fixed.h"
  
 /************************************************************************/
 /* Local Definitions (private functions)                                */
 /************************************************************************/
- 
-// Calculate the distance (in cm) of the sound pulse from the duration (in us)
-float calculateDistance(long duration);
+
+// mm travelled (one way) for every us of echo -- speed of sound (cm/us ==> mm/us) / 2 [there and back]
+#define ULTRASONIC_MM_PER_US FIX16_FROM_FLOAT(ULTRASONIC_SPEED_OF_SOUND * 10 / 2)
  
 /************************************************************************/
 /* Global Variables                                                     */
@@ -24,19 +25,59 @@ float calculateDistance(long duration);
 /* Header Implementation                                                */
 /************************************************************************/
  
-bool Ultrasonic_CheckForObstacle(long duration, int range)
+bool Ultrasonic_CheckForObstacle(long duration, long rangeDuration)
 {
-	float distance = calculateDistance(duration);
-	 
-	return distance >= 0 && distance < range ? 1 : 0;
+	return Ultrasonic_HasEcho(duration) && duration < rangeDuration ? 1 : 0;
 }
 
-/************************************************************************/
-/* Local  Implementation                                                */
-/************************************************************************/
+bool Ultrasonic_HasEcho(long duration)
+{
+	return duration > ULTRASONIC_NO_ECHO && duration < ULTRASONIC_TIMEOUT;
+}
+
+long Ultrasonic_CalculateDistance(long duration)
+{
+	// the max duration (0x1FFFF) times the factor still fits in 32 bits, so no need for a 64 bit multiply
+	return (duration * ULTRASONIC_MM_PER_US) >> 16; //calculation retrieved from datasheet (see header file)
+}
 
-float calculateDistance(long duration)
+void Ultrasonic_UpdateTrack(struct Ultrasonic_Track * track, long distance, uint64_t time)
 {
-	float speed = 0.0343; // speed of sound in cm/us -- speed pulled from google as 343m/s in dry air at 20C on Feb 24th, 2023
-	return (duration * speed) / 2; //calculation retrieved from datasheet (see header file)
+	if(track->set && time > track->time)
+	{
+		// us is too fine for the division, work in ms (the frames are ~100ms apart)
+		long elapsed = (long) ((time - track->time) / 1000);
+		fix16_t rate = elapsed > 0 ? (fix16_t) ((int64_t) FIX16_FROM_INT(distance - track->distance) * 1000 / elapsed) : 0;
+
+		if(rate > FIX16_FROM_INT(ULTRASONIC_MAX_RATE) || rate < -FIX16_FROM_INT(ULTRASONIC_MAX_RATE))
+			track->rate = 0;
+		else
+			track->rate += fix16_mul(rate - track->rate, ULTRASONIC_RATE_SMOOTHING);
+	}
+	else if(!track->set)
+	{
+		track->rate = 0;
+	}
+
+	track->distance = distance;
+	track->time = time;
+	track->set = 1;
+}
+
+fix16_t Ultrasonic_TimeToCollision(struct Ultrasonic_Track * track)
+{
+	if(!track->set || track->rate >= 0)
+		return FIX16_MAX;
+	if(track->distance <= 0)
+		return 0;
+
+	// distance / closing speed, ms first so a slow closing speed can't overflow
+	long milliseconds = (long) (((int64_t) track->distance * 1000 << 16) / -track->rate);
+	if(milliseconds >= 32767000)
+		return FIX16_MAX;
+	return (fix16_t) (((int64_t) milliseconds << 16) / 1000);
 }
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
@@ -6,6 +6,33 @@
  * Created: 2023-03-14
  * Author: Kia Skretteberg
  */ 
+#ifndef ULTRASONICH
+#define ULTRASONICH
+
+#include "pico/stdlib.h"
+#include "../fixed/fixed.h"
+
+#define ULTRASONIC_SPEED_OF_SOUND 0.0343 // speed of sound in cm/us -- 343m/s in dry air at 20C
+
+// Convert a range (in cm) into the echo duration (in us) it takes to get there and back (duration = range * 2 / speed)
+// Only use this on constants, so the conversion is done at compile time and the runtime check is a single comparison
+#define Ultrasonic_RangeToDuration(range) ((long) ((range) * 2 / ULTRASONIC_SPEED_OF_SOUND + 0.5))
+
+// Where the sensors are mounted: distance (in mm) forward of the centre of the robot,
+// and the direction each one faces (in degrees, counter-clockwise from straight ahead)
+#define ULTRASONIC_MOUNT_OFFSET 150
+#define ULTRASONIC_L_ANGLE      30
+#define ULTRASONIC_C_ANGLE      0
+#define ULTRASONIC_R_ANGLE      -30
+#define ULTRASONIC_BEAM_ANGLE   15 // degrees either side of the direction the sensor faces that it picks things up
+
+// Echo durations that mean nothing was seen: no echo at all, or the sensor giving up waiting (the most the frame holds)
+#define ULTRASONIC_NO_ECHO        0
+#define ULTRASONIC_TIMEOUT        0x1FFFF
+
+// Range rate tracking
+#define ULTRASONIC_RATE_SMOOTHING FIX16_FROM_FLOAT(0.5) // fraction of each new range rate taken into the estimate
+#define ULTRASONIC_MAX_RATE       3000                  // mm/s, anything faster is a different object coming into view, not movement
 
 typedef enum
 {
@@ -14,6 +41,29 @@ typedef enum
 	Ultrasonic_R = 2, // segment 6 (5 bytes)
 } Ultrasonic_Device;
 
+// The distance to whatever a sensor sees, and how fast that is changing
+struct Ultrasonic_Track {
+	long distance;      // mm
+	fix16_t rate;       // mm/s, negative when getting closer
+	uint64_t time;      // us, when the distance was measured
+	bool set;           // 1 once there's been a distance
+};
+
 // Determine if there's an obstacle within a specified range based on the duration
+// The range is given as an echo duration (see Ultrasonic_RangeToDuration)
 // 0 = no obstacle, 1 = obstacle
-bool Ultrasonic_CheckForObstacle(long duration, int range);
+bool Ultrasonic_CheckForObstacle(long duration, long rangeDuration);
+
+// Check if a duration is an echo from something (not a failed read, no echo or the sensor timing out)
+bool Ultrasonic_HasEcho(long duration);
+
+// Calculate the distance (in mm) of the sound pulse from the duration (in us)
+long Ultrasonic_CalculateDistance(long duration);
+
+// Add a new distance (in mm, measured at a time in us) to a track, updating the range rate
+void Ultrasonic_UpdateTrack(struct Ultrasonic_Track * track, long distance, uint64_t time);
+
+// Calculate how long (in s) until the robot reaches what the track sees, at the rate it is closing (FIX16_MAX if it isn't)
+fix16_t Ultrasonic_TimeToCollision(struct Ultrasonic_Track * track);
+
+#endif
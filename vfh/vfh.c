@@ -0,0 +1,182 @@
+/*
+ * vfh.c
+ *
+ * Created: 2026-10-19
+ */
+#include <string.h>
+#include "pico/stdlib.h"
+#include "vfh.h"
+
+/************************************************************************/
+/* Local Definitions (private functions)                                */
+/************************************************************************/
+
+/// @brief Find the sector a direction falls in
+/// @param angle The direction (in rad, any range)
+/// @return The sector (0 to VFH_SECTORS - 1, counter-clockwise from the x axis)
+int sector_from_angle(fix16_t angle);
+
+/// @brief Wrap a sector number that may have gone past either end
+/// @param sector The sector number
+/// @return The sector (0 to VFH_SECTORS - 1)
+int wrap_sector(int sector);
+
+/// @brief Check if the robot fits through a sector (it and the VFH_ROBOT_SECTORS either side are clear)
+/// @param sector The sector
+/// @return 1 if it fits
+bool robot_fits(int sector);
+
+/// @brief Work out how fast to drive through a sector from the most seen around it
+/// @param sector The sector
+/// @return The fraction of full speed (VFH_MIN_SPEED to 1)
+fix16_t sector_speed(int sector);
+
+/************************************************************************/
+/* Global Variables                                                     */
+/************************************************************************/
+
+uint16_t sector_weights[VFH_SECTORS];
+bool sector_blocked[VFH_SECTORS];
+
+// which way the last detour went, so the robot keeps going around an obstacle the same way when both ways are as good
+bool detour_left = 1;
+
+/************************************************************************/
+/* Header Implementation                                                */
+/************************************************************************/
+
+void vfh_clear(void)
+{
+    memset(sector_weights, 0, sizeof(sector_weights));
+    memset(sector_blocked, 0, sizeof(sector_blocked));
+}
+
+void vfh_fade(void)
+{
+    int sector;
+    for(sector = 0; sector < VFH_SECTORS; ++sector)
+        sector_weights[sector] -= sector_weights[sector] >> VFH_FADE_SHIFT;
+}
+
+void vfh_add_reading(fix16_t angle, fix16_t spread, long distance)
+{
+    if(distance >= VFH_RANGE)
+        return;
+    if(distance < 0)
+        distance = 0;
+
+    // the closer it is, the more it counts
+    uint32_t weight = VFH_RANGE - distance;
+    int sector = sector_from_angle(angle - spread);
+    int last = sector_from_angle(angle + spread);
+
+    while(true)
+    {
+        uint32_t total = sector_weights[sector] + weight;
+        sector_weights[sector] = total > UINT16_MAX ? UINT16_MAX : total;
+
+        if(sector == last)
+            break;
+        sector = wrap_sector(sector + 1);
+    }
+}
+
+struct VfhChoice vfh_choose(fix16_t goal)
+{
+    struct VfhChoice choice;
+    int sector, offset;
+
+    choice.clear = 0;
+    choice.heading = goal;
+    choice.speed = 0;
+
+    for(sector = 0; sector < VFH_SECTORS; ++sector)
+    {
+        if(sector_weights[sector] >= VFH_BLOCKED)
+            sector_blocked[sector] = 1;
+        else if(sector_weights[sector] <= VFH_CLEARED)
+            sector_blocked[sector] = 0;
+    }
+
+    // work outwards from the goal, trying the same side as the last detour first
+    int goalSector = sector_from_angle(goal);
+    int first = detour_left ? 1 : -1;
+
+    for(offset = 0; offset <= VFH_SECTORS / 2; ++offset)
+    {
+        int side;
+        for(side = 0; side < 2; ++side)
+        {
+            int direction = side == 0 ? first : -first;
+            sector = wrap_sector(goalSector + direction * offset);
+
+            if(!robot_fits(sector))
+                continue;
+
+            choice.clear = 1;
+            choice.speed = sector_speed(sector);
+            // head straight for the goal if nothing is in the way, otherwise through the middle of the gap
+            if(offset > 0)
+            {
+                choice.heading = fix16_wrap_angle(sector * (FIX16_TWO_PI / VFH_SECTORS) + (FIX16_TWO_PI / VFH_SECTORS / 2));
+                detour_left = direction > 0;
+            }
+            return choice;
+        }
+    }
+
+    return choice;
+}
+
+/************************************************************************/
+/* Local  Implementation                                                */
+/************************************************************************/
+
+int sector_from_angle(fix16_t angle)
+{
+    angle %= FIX16_TWO_PI;
+    if(angle < 0)
+        angle += FIX16_TWO_PI;
+
+    return (angle * VFH_SECTORS) / FIX16_TWO_PI;
+}
+
+int wrap_sector(int sector)
+{
+    if(sector < 0)
+        return sector + VFH_SECTORS;
+    if(sector >= VFH_SECTORS)
+        return sector - VFH_SECTORS;
+    return sector;
+}
+
+bool robot_fits(int sector)
+{
+    int offset;
+    for(offset = -VFH_ROBOT_SECTORS; offset <= VFH_ROBOT_SECTORS; ++offset)
+    {
+        if(sector_blocked[wrap_sector(sector + offset)])
+            return 0;
+    }
+    return 1;
+}
+
+fix16_t sector_speed(int sector)
+{
+    uint16_t most = 0;
+    int offset;
+
+    for(offset = -VFH_ROBOT_SECTORS; offset <= VFH_ROBOT_SECTORS; ++offset)
+    {
+        uint16_t weight = sector_weights[wrap_sector(sector + offset)];
+        if(weight > most)
+            most = weight;
+    }
+
+    // nothing seen is full speed, down to the minimum as it gets to the point of being blocked
+    if(most >= VFH_BLOCKED)
+        return VFH_MIN_SPEED;
+
+    fix16_t clearance = FIX16_ONE - (fix16_t) (((int64_t) most << 16) / VFH_BLOCKED);
+    return VFH_MIN_SPEED + fix16_mul(FIX16_ONE - VFH_MIN_SPEED, clearance);
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+/*
+ * vfh.h
+ * Vector field histogram for steering around nearby obstacles
+ *
+ * The area around the robot is split into VFH_SECTORS directions (fixed to the UWB axes, so what's been seen stays put while
+ * the robot turns), each holding how much has been seen in that direction and how close it was
+ * Every reading adds to the sectors it covers, and everything fades as new frames come in, so only recent readings count
+ * A sector is blocked once it passes VFH_BLOCKED, and only clear again once it drops below VFH_CLEARED (so it can't flicker)
+ *
+ * The heading chosen is the clear one closest to the goal that the robot fits through, with how clear it is
+ * given as the fraction of full speed to drive at
+ *
+ * Created: 2026-10-19
+ */
+#ifndef VFHH
+#define VFHH
+
+#include "pico/stdlib.h"
+#include "../fixed/fixed.h"
+
+#define VFH_SECTORS         36                      // 10 degrees each
+#define VFH_RANGE           1000                    // mm, anything further away is ignored
+#define VFH_FADE_SHIFT      3                       // each frame keeps 7/8 of what was there (a steady reading settles at 8x its weight)
+#define VFH_BLOCKED         (8 * (VFH_RANGE - 500)) // an obstacle seen steadily at 500mm blocks its sector
+#define VFH_CLEARED         (8 * (VFH_RANGE - 700)) // and it has to fade to as if it were at 700mm to clear
+#define VFH_ROBOT_SECTORS   1                       // sectors either side of a heading that also have to be clear for the robot to fit
+#define VFH_MIN_SPEED       FIX16_FROM_FLOAT(0.25)  // fraction of full speed to drive at when the heading is only just clear
+
+struct VfhChoice {
+    bool clear;         // 0 if there's no heading the robot fits through
+    fix16_t heading;    // rad, counter-clockwise from the x axis
+    fix16_t speed;      // fraction of full speed to drive at (VFH_MIN_SPEED to 1)
+};
+
+// Forget everything that's been seen
+void vfh_clear(void);
+
+// Fade everything that's been seen (call once for every new frame of readings)
+void vfh_fade(void);
+
+// Add a reading of something at a distance (in mm) in a direction (in rad, counter-clockwise from the x axis)
+// The reading covers the sectors within the spread (in rad) either side of that direction
+void vfh_add_reading(fix16_t angle, fix16_t spread, long distance);
+
+// Choose the clear heading closest to the goal heading (in rad)
+struct VfhChoice vfh_choose(fix16_t goal);
+
+#endif
\ No newline at end of file
@@ -16,8 +16,7 @@
 /* Global Variables                                                     */
 /************************************************************************/
 
-volatile struct Web_Request requests[4];
-volatile char bodyBuff[1000];
+volatile struct Web_Request requests[6];
 volatile char headerBuff[1000];
 httpc_connection_t settings;
 const uint32_t COUNTRY = CYW43_COUNTRY_CANADA;
@@ -29,6 +28,19 @@ const char PROPERTY_DELIM = ';';
 const char PROPERTY_DELIM_STR[] = ";";
 const char VALUE_DELIM = ':';
 
+// What web_init was given, for web_poll to connect with
+const char * web_ssid;
+const char * web_pass;
+ip_addr_t * web_ip;
+ip_addr_t * web_mask;
+ip_addr_t * web_gw;
+
+// The last link status seen, when to try connecting again after a failure and when to next toggle the LED
+int web_link_status = CYW43_LINK_DOWN;
+uint64_t web_retry_time = 0;
+uint64_t web_blink_time = 0;
+bool web_led_on = 0;
+
 /************************************************************************/
 /* Local Definitions (private functions)                                */
 /************************************************************************/
@@ -42,6 +54,8 @@ err_t headers_callback(httpc_state_t *connection, void *arg,
 err_t body_callback(void *arg, struct altcp_pcb *conn, 
                             struct pbuf *p, err_t err);
 
+void link_connected(void);
+
 /************************************************************************/
 /* Header Implementation                                                */
 /************************************************************************/
@@ -60,65 +74,16 @@ int web_init(const char *ssid, const char *pass, const char *hostname,
         netif_set_hostname(netif_default, hostname);
     }
 
-    if (cyw43_arch_wifi_connect_async(ssid, pass, AUTH))
-    {
-        return 2;
-    }
+    // kept for web_poll, to retry with and to set up the interface once connected
+    web_ssid = ssid;
+    web_pass = pass;
+    web_ip = ip;
+    web_mask = mask;
+    web_gw = gw;
 
-    int flashrate = 1000;
-    int status = CYW43_LINK_UP + 1;
-    while (status != CYW43_LINK_UP)
-    {
-        int new_status = cyw43_tcpip_link_status(
-             &cyw43_state,CYW43_ITF_STA);
-        if (new_status != status)
-        {
-            status = new_status;
-            if(status != -1) flashrate = flashrate / (status + 1);
-            printf("connect status: %d %d\n", 
-                                    status, flashrate);
-        }
-        cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 1);
-        sleep_ms(flashrate);
-        cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 0);
-        sleep_ms(flashrate);
-    }
-    if (status < 0)
-    {
-        cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 0);
-    }
-    else
-    {
-        cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 1);
-        if (ip != NULL)
-        {
-            netif_set_ipaddr(netif_default, ip);
-        }
-        if (mask != NULL)
-        {
-            netif_set_netmask(netif_default, mask);
-        }
-        if (gw != NULL)
-        {
-            netif_set_gw(netif_default, gw);
-        }
-        printf("IP: %s\n",
-        ip4addr_ntoa(netif_ip_addr4(netif_default)));
-        printf("Mask: %s\n", 
-        ip4addr_ntoa(netif_ip_netmask4(netif_default)));
-        printf("Gateway: %s\n",
-        ip4addr_ntoa(netif_ip_gw4(netif_default)));
-        printf("Host Name: %s\n",
-        netif_get_hostname(netif_default));
-    }
     settings.result_fn = result_callback;
     settings.headers_done_fn = headers_callback;
 
-    // setup the check schedule request 
-    requests[Web_RequestType_CheckSchedule].type = Web_RequestType_CheckSchedule;
-    requests[Web_RequestType_CheckSchedule].active = 0;
-    strcpy(requests[Web_RequestType_CheckSchedule].body, "");
-    strcpy(requests[Web_RequestType_CheckSchedule].headers, "");
     // setup the log delivery request
     requests[Web_RequestType_LogDelivery].type = Web_RequestType_LogDelivery;
     requests[Web_RequestType_LogDelivery].active = 0;
@@ -134,15 +99,88 @@ int web_init(const char *ssid, const char *pass, const char *hostname,
     requests[Web_RequestType_GetUserLocation].active = 0;
     strcpy(requests[Web_RequestType_GetUserLocation].body, "");
     strcpy(requests[Web_RequestType_GetUserLocation].headers, "");
-    return status;
+    // setup the report stuck request
+    requests[Web_RequestType_ReportStuck].type = Web_RequestType_ReportStuck;
+    requests[Web_RequestType_ReportStuck].active = 0;
+    strcpy(requests[Web_RequestType_ReportStuck].body, "");
+    strcpy(requests[Web_RequestType_ReportStuck].headers, "");
+    // setup the get zones request
+    requests[Web_RequestType_GetZones].type = Web_RequestType_GetZones;
+    requests[Web_RequestType_GetZones].active = 0;
+    strcpy(requests[Web_RequestType_GetZones].body, "");
+    strcpy(requests[Web_RequestType_GetZones].headers, "");
+    // setup the get deliveries request
+    requests[Web_RequestType_GetDeliveries].type = Web_RequestType_GetDeliveries;
+    requests[Web_RequestType_GetDeliveries].active = 0;
+    strcpy(requests[Web_RequestType_GetDeliveries].body, "");
+    strcpy(requests[Web_RequestType_GetDeliveries].headers, "");
+
+    // the rest of connecting carries on in the background, see web_poll (which tries again if this fails)
+    web_retry_time = time_us_64() + WEB_RETRY_DURATION;
+    if (cyw43_arch_wifi_connect_async(ssid, pass, AUTH))
+    {
+        return 2;
+    }
+    return 0;
+}
+
+bool web_poll(void)
+{
+    uint64_t now = time_us_64();
+    int status = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+
+    if (status != web_link_status)
+    {
+        web_link_status = status;
+        printf("connect status: %d\n", status);
+        if (status == CYW43_LINK_UP)
+        {
+            link_connected();
+        }
+        else if (status <= CYW43_LINK_DOWN)
+        {
+            // the network wasn't found, wouldn't let us on or dropped us, give it a while before trying again
+            web_retry_time = now + WEB_RETRY_DURATION;
+        }
+    }
+
+    if (status == CYW43_LINK_UP)
+    {
+        return 1;
+    }
+
+    if (status <= CYW43_LINK_DOWN && now >= web_retry_time)
+    {
+        web_retry_time = now + WEB_RETRY_DURATION;
+        (void) cyw43_arch_wifi_connect_async(web_ssid, web_pass, AUTH);
+    }
+
+    // blink the LED while connecting, faster the further along it gets
+    if (now >= web_blink_time)
+    {
+        web_led_on = !web_led_on;
+        cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, web_led_on);
+        web_blink_time = now + (status >= 0 ? 1000000 / (status + 1) : 1000000);
+    }
+    return 0;
+}
+
+bool web_ready(void)
+{
+    return web_link_status == CYW43_LINK_UP;
 }
 
 void web_request(char * uriParams, Web_RequestType type)
 {
     char uri[2049];
     strcpy(uri, WEB_CLIENT_REQUEST_URL);
-    if(!requests[type].active) {
+    // (without a connection the request is dropped, and looks to the caller like one that failed)
+    if(!requests[type].active && web_ready()) {
         requests[type].active = 1;
+        // the body comes in a piece at a time, see body_callback
+        requests[type].body[0] = '\0';
+        requests[type].length = 0;
+        requests[type].truncated = 0;
         printf("\nMake request to: ");
         printf(strcat(uri, uriParams));
         printf("\nend");
@@ -152,21 +190,22 @@ void web_request(char * uriParams, Web_RequestType type)
                 uri,
                 &settings,
                 body_callback,
-                &type, //TODO: Pass a value to track this specific request
+                (void *) &requests[type].type, // (the callbacks come long after this returns, so not a local)
                 NULL
             ); 
         
         //printf("status %d \n", err);
+        // the callbacks won't ever come for a request that couldn't be started
+        if(err != ERR_OK)
+        {
+            requests[type].active = 0;
+        }
     }
 }
 
-void web_request_check_schedule(void)
+bool web_request_active(Web_RequestType type)
 {
-    // build the url for checking schedule
-    char url[2048] = "/check_schedule/device/";
-    strcat(url, DEVICE_SERIAL);
-    // make the request to the specified url
-    web_request(url, Web_RequestType_CheckSchedule);
+    return requests[type].active;
 }
 
 void web_request_retrieve_dose_stats(int schedule_id)
@@ -189,6 +228,16 @@ void web_request_log_delivery(int schedule_id)
     web_request(url, Web_RequestType_LogDelivery);
 }
 
+void web_request_report_stuck(int schedule_id, long x, long y)
+{
+    // build the url for reporting where the robot is stuck
+    char url[2048] = "/report_stuck/device/";
+    strcat(url, DEVICE_SERIAL);
+    snprintf(url + strlen(url), sizeof(url) - strlen(url), "/schedule_id/%i/x/%ld/y/%ld", schedule_id, x, y);
+    // make the request to the specified url
+    web_request(url, Web_RequestType_ReportStuck);
+}
+
 void web_request_get_user_location(void)//int user_id)
 {
     // build the url for logging delivery
@@ -200,47 +249,38 @@ void web_request_get_user_location(void)//int user_id)
     web_request(url, Web_RequestType_GetUserLocation);
 }
 
-int web_response_check_schedule(void)
+void web_request_get_zones(void)
 {
-    Web_RequestType type = Web_RequestType_CheckSchedule;
-    if(requests[type].active && requests[type].complete) 
-    {
-        printf("\ncheck schedule request complete");
-        char userId[20] = "";       // "UserID:############"
-        char scheduleId[24] = "";   // "ScheduleID:############"
-        char * chunk;
-        int userIdValue = -1;
-        int scheduleIdValue = -1;
-
-        // split out the userid and scheduleid property/value pairs
-        strcpy(scheduleId, strchr(requests[type].body, PROPERTY_DELIM));
-        strcpy(userId, strtok(requests[type].body, PROPERTY_DELIM_STR));
-        
-        // grab out the user id value from the property/value pair
-        chunk = strchr(userId, VALUE_DELIM);
-        ++chunk;
-        userIdValue = atoi(chunk);
+    // build the url for getting the keep out/slow zones
+    char url[2048] = "/get_zones/device/";
+    strcat(url, DEVICE_SERIAL);
+    // make the request to the specified url
+    web_request(url, Web_RequestType_GetZones);
+}
 
-        // grab out the schedule id value from the property/value pair
-        chunk = strchr(scheduleId, VALUE_DELIM);
-        ++chunk;
-        scheduleIdValue = atoi(chunk);
+void web_request_get_deliveries(void)
+{
+    // build the url for getting every delivery that is due
+    char url[2048] = "/get_deliveries/device/";
+    strcat(url, DEVICE_SERIAL);
+    // make the request to the specified url
+    web_request(url, Web_RequestType_GetDeliveries);
+}
 
+bool web_response_log_delivery(void)
+{
+    Web_RequestType type = Web_RequestType_LogDelivery;
+    if(requests[type].active && requests[type].complete) 
+    {
         // reset the request so a new one can be made
         requests[type].active = 0;
         strcpy(requests[type].headers, "");
         strcpy(requests[type].body, "");
         requests[type].complete = 0;
-
-        if(scheduleIdValue == -1)
-        {
-            printf("\nno schedule");
-        }
-
-        // return the schedule id
-        return scheduleIdValue;
+        return 1;
     }
-    return -1;
+
+    return 0;
 }
 
 int web_response_retrieve_dose_stats(void)
@@ -301,6 +341,102 @@ struct DWM1001_Position web_response_get_user_location(void)
     return position;
 }
 
+bool web_response_get_zones(struct GeofenceZones * zones)
+{
+    Web_RequestType type = Web_RequestType_GetZones;
+    if(requests[type].active && requests[type].complete) 
+    {
+        printf("\nget zones request complete");
+        // one zone per property: "Speed:###,x,y,x,y,..." (speed is the percentage of full speed allowed, 0 keeps out)
+        char * chunk = strtok(requests[type].body, PROPERTY_DELIM_STR);
+
+        zones->count = 0;
+        while(chunk != NULL && zones->count < GEOFENCE_MAX_ZONES)
+        {
+            struct GeofenceZone * zone = &zones->zones[zones->count];
+            char * value = strchr(chunk, VALUE_DELIM);
+            char * end;
+
+            if(value != NULL)
+            {
+                zone->speed = FIX16_FROM_INT(strtol(value + 1, &end, 10)) / 100;
+                zone->count = 0;
+                // the rest are pairs of coordinates
+                while(*end == ',' && zone->count < GEOFENCE_MAX_VERTICES)
+                {
+                    zone->vertices[zone->count].x = strtol(end + 1, &end, 10);
+                    if(*end != ',')
+                        break;
+                    zone->vertices[zone->count].y = strtol(end + 1, &end, 10);
+                    ++zone->count;
+                }
+                if(zone->count >= 3)
+                    ++zones->count;
+            }
+            chunk = strtok(NULL, PROPERTY_DELIM_STR);
+        }
+
+        // reset the request so a new one can be made
+        requests[type].active = 0;
+        strcpy(requests[type].headers, "");
+        strcpy(requests[type].body, "");
+        requests[type].complete = 0;
+        return 1;
+    }
+
+    return 0;
+}
+
+bool web_response_get_deliveries(struct Tour * tour, long * nextDue)
+{
+    Web_RequestType type = Web_RequestType_GetDeliveries;
+    if(requests[type].active && requests[type].complete) 
+    {
+        printf("\nget deliveries request complete");
+        // one delivery per property: "ScheduleID:###,x,y" (where its user is, in mm)
+        // and optionally "NextDue:###" (s until the next delivery comes due)
+        char * chunk = strtok(requests[type].body, PROPERTY_DELIM_STR);
+
+        tour->count = 0;
+        tour->next = 0;
+        *nextDue = -1;
+        while(chunk != NULL && tour->count < TOUR_MAX_STOPS)
+        {
+            struct TourStop * stop = &tour->stops[tour->count];
+            char * value = strchr(chunk, VALUE_DELIM);
+            char * end;
+
+            if(strncmp(chunk, "NextDue:", 8) == 0)
+            {
+                *nextDue = strtol(value + 1, &end, 10);
+            }
+            else if(value != NULL)
+            {
+                stop->scheduleId = strtol(value + 1, &end, 10);
+                if(*end == ',')
+                {
+                    stop->x = strtol(end + 1, &end, 10);
+                    if(*end == ',')
+                    {
+                        stop->y = strtol(end + 1, &end, 10);
+                        ++tour->count;
+                    }
+                }
+            }
+            chunk = strtok(NULL, PROPERTY_DELIM_STR);
+        }
+
+        // reset the request so a new one can be made
+        requests[type].active = 0;
+        strcpy(requests[type].headers, "");
+        strcpy(requests[type].body, "");
+        requests[type].complete = 0;
+        return 1;
+    }
+
+    return 0;
+}
+
 /************************************************************************/
 /* Local  Implementation                                                */
 /************************************************************************/
@@ -313,7 +449,8 @@ void result_callback(void *arg, httpc_result_t httpc_result,
     // printf("local result=%d\n", httpc_result);
     // printf("http result=%d\n", srv_res);
     // if the request was successful, mark this request as complete
-    if(srv_res == 200) 
+    // nothing reads a response to a report, so it's finished as soon as it's made
+    if(srv_res == 200 && !requests[type].truncated && type != Web_RequestType_ReportStuck) 
     {
         requests[type].complete = 1;
     }
@@ -333,7 +470,7 @@ err_t headers_callback(httpc_state_t *connection, void *arg,
     // printf("headers recieved\n");
     // printf("content length=%d\n", content_len);
     // printf("header length %d\n", hdr_len);
-    pbuf_copy_partial(hdr, headerBuff, hdr->tot_len, 0);
+    pbuf_copy_partial(hdr, (char *) headerBuff, sizeof(headerBuff) - 1, 0);
     // printf("headers \n");
     // printf("%s", buff);
     // strcpy(requests[type].headers, buff);
@@ -344,9 +481,44 @@ err_t body_callback(void *arg, struct altcp_pcb *conn,
                             struct pbuf *p, err_t err)
 {
     Web_RequestType type = *((Web_RequestType *)arg);
+    volatile struct Web_Request * request = &requests[type];
     //printf("body\n");
-    pbuf_copy_partial(p, bodyBuff, p->tot_len, 0);
+    // a body longer than a pbuf comes in several calls, each appended after the last (leaving room for the terminator)
+    size_t space = sizeof(request->body) - request->length - 1;
+    if(p->tot_len > space)
+    {
+        request->truncated = 1;
+    }
+    request->length += pbuf_copy_partial(p, (char *) request->body + request->length, space, 0);
+    request->body[request->length] = '\0';
     // printf("\nBUFF:\n%s", buff);
-    strcpy(requests[type].body, bodyBuff);
+    // (the pbuf is ours to free once it's been read)
+    altcp_recved(conn, p->tot_len);
+    pbuf_free(p);
     return ERR_OK;
+}
+
+void link_connected(void)
+{
+    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 1);
+    if (web_ip != NULL)
+    {
+        netif_set_ipaddr(netif_default, web_ip);
+    }
+    if (web_mask != NULL)
+    {
+        netif_set_netmask(netif_default, web_mask);
+    }
+    if (web_gw != NULL)
+    {
+        netif_set_gw(netif_default, web_gw);
+    }
+    printf("IP: %s\n",
+    ip4addr_ntoa(netif_ip_addr4(netif_default)));
+    printf("Mask: %s\n", 
+    ip4addr_ntoa(netif_ip_netmask4(netif_default)));
+    printf("Gateway: %s\n",
+    ip4addr_ntoa(netif_ip_gw4(netif_default)));
+    printf("Host Name: %s\n",
+    netif_get_hostname(netif_default));
 }
\ No newline at end of file
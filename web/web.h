@@ -10,38 +10,62 @@
  */
 #include "lwip/apps/http_client.h"
 #include "../dwm1001/dwm1001.h"
+#include "../geofence/geofence.h"
+#include "../tour/tour.h"
 
 #define WEB_CLIENT_SERVER       "api.rx-arven.com"
 #define WEB_CLIENT_REQUEST_URL  "/api" 
 #define WEB_CLIENT_PORT         80 //TODO: Should/can we use a different port?
+#define WEB_RETRY_DURATION      10000000 // 10s (in us) between attempts to connect after one fails
+#define WEB_BODY_LENGTH         2048 // the largest response is the zones (8 of 16 vertices, ~1.7KB at the grid's extent)
 
 typedef enum
 {
-	Web_RequestType_CheckSchedule = 0,
-	Web_RequestType_LogDelivery = 1,
-    Web_RequestType_RetrieveDoseStats = 2,
-    Web_RequestType_GetUserLocation = 3
+	Web_RequestType_LogDelivery = 0,
+    Web_RequestType_RetrieveDoseStats = 1,
+    Web_RequestType_GetUserLocation = 2,
+    Web_RequestType_ReportStuck = 3,
+    Web_RequestType_GetZones = 4,
+    Web_RequestType_GetDeliveries = 5
 } Web_RequestType;
 
 struct Web_Request {
     bool active;
     char headers[1000];
-    char body[1000];
+    char body[WEB_BODY_LENGTH];
+    size_t length;      // of the body received so far
+    bool truncated;     // the body didn't fit, so the request failed
     bool complete;
     Web_RequestType type;
 };
 
 
+// Start the wifi chip and start connecting to the network. Returns 0 if connecting has started,
+// 1 if the chip didn't start, 2 if connecting didn't start (web_poll will try again)
 int web_init(const char *ssid, const char *pass, const char *hostname, 
                 ip_addr_t *ip, ip_addr_t *mask, ip_addr_t *gw);
+// Keep connecting (or reconnecting) in the background, call it regularly. Returns 1 once connected
+bool web_poll(void);
+// Check if the network is connected (requests made before then are dropped)
+bool web_ready(void);
 
 void web_request(char * uriParams, Web_RequestType type);
+// Check if a request of the type has been made and its response hasn't been handled yet
+bool web_request_active(Web_RequestType type);
 
-void web_request_check_schedule(void);
 void web_request_retrieve_dose_stats(int schedule_id);
 void web_request_log_delivery(int schedule_id);
+void web_request_report_stuck(int schedule_id, long x, long y);
 void web_request_get_user_location(void);// Ideally this would pass a user_id but we're skipping that for now //int user_id);
+void web_request_get_zones(void);
+void web_request_get_deliveries(void);
 
-int web_response_check_schedule(void);
 int web_response_retrieve_dose_stats(void);
-struct DWM1001_Position web_response_get_user_location(void);
\ No newline at end of file
+// Check if the server has logged the delivery, returns 1 once it has (the request is inactive again if it failed)
+bool web_response_log_delivery(void);
+struct DWM1001_Position web_response_get_user_location(void);
+// Fill in the keep out/slow zones from the response, returns 1 once it has come in
+bool web_response_get_zones(struct GeofenceZones * zones);
+// Fill in the stops of every delivery that is due (in the order the server gave them) and how long (in s) until the next
+// one comes due (-1 if the server didn't say), returns 1 once it has come in
+bool web_response_get_deliveries(struct Tour * tour, long * nextDue);
\ No newline at end of file
@@ -12,34 +12,27 @@
 /* Local Definitions (private functions)                                */
 /************************************************************************/
 
-float calculateVoltage(int atodval);
-
 /************************************************************************/
 /* Global Variables                                                     */
 /************************************************************************/
 
-volatile float previousWeight = 0;
-volatile float doseWeight = 0;
-const float BOTTLE_WEIGHT = 10; //measured in grams
+volatile fix16_t previousWeight = 0;
+volatile fix16_t doseWeight = 0;
+volatile int tareAtodval = 0; // reading with nothing on the sensor
+const fix16_t BOTTLE_WEIGHT = FIX16_FROM_INT(10); //measured in grams
+const fix16_t DOSE_TOLERANCE = FIX16_FROM_FLOAT(1.1); // a dose plus 10% for error
 
 /************************************************************************/
 /* Header Implementation                                                */
 /************************************************************************/
 
-float Weight_CalculateMass(int atodval)
+fix16_t Weight_CalculateMass(int atodval)
 {
-	float voltage = calculateVoltage(atodval);
-	// 1000.0 is the conversion factor for kg to g
-	// 9.81 is gravity
-	// g = N * (g/kg) / m/s^2
-	float max_weight = (Weight_MAXN * 1000.0) / 9.81;
-	
-	float weight = (voltage / AREF) * max_weight;
-	
-	return weight;
+	// atodval is at most 10 bits, so this can't overflow
+	return (atodval - tareAtodval) * Weight_GRAMS_PER_ATODVAL;
 }
 
-float Weight_DetermineDosage(float startingWeight, int numDoses)
+fix16_t Weight_DetermineDosage(fix16_t startingWeight, int numDoses)
 {
 	//TODO: We would want to improve it to allow a user to 
 	// configure which standard bottle they are using which would determine
@@ -49,31 +42,39 @@ float Weight_DetermineDosage(float startingWeight, int numDoses)
 	return doseWeight;
 }
 
+void Weight_SetTare(int atodval)
+{
+	tareAtodval = atodval;
+}
+
+int Weight_GetTare(void)
+{
+	return tareAtodval;
+}
+
 Weight_LoadState Weight_CheckForLoad(int atodval)
 {	
-	if(atodval > MAX_ATODVAL) return Weight_LoadError;
-
-	float voltage = calculateVoltage(atodval);
+	if(atodval > (int) MAX_ATODVAL) return Weight_LoadError;
 
-	return voltage > Weight_MINV ? Weight_LoadPresent : Weight_LoadNotPresent;
+	return atodval > tareAtodval + Weight_MIN_ATODVAL ? Weight_LoadPresent : Weight_LoadNotPresent;
 }
 
 Weight_Change Weight_CheckForChange(int atodval)
 {
 	Weight_Change change;
-	float newWeight = Weight_CalculateMass(atodval);
-	float weightDifference = previousWeight - newWeight;
-	printf("\nnewWeight: %f", newWeight);
-	printf("\npreviousWeight: %f", previousWeight);
-	printf("\ndoseWeight: %f", doseWeight);
-	printf("\nweightDifference: %f", weightDifference);
+	fix16_t newWeight = Weight_CalculateMass(atodval);
+	fix16_t weightDifference = previousWeight - newWeight;
+	printf("\nnewWeight: %d", FIX16_TO_INT(newWeight));
+	printf("\npreviousWeight: %d", FIX16_TO_INT(previousWeight));
+	printf("\ndoseWeight: %d", FIX16_TO_INT(doseWeight));
+	printf("\nweightDifference: %d", FIX16_TO_INT(weightDifference));
 	
 	// The weight went up, track as a refill
 	if(weightDifference < 0)
 		change = Weight_RefillChange;
 	// TODO: if it's too much below a dose, should it track?
 	// The difference is less than or equal to a dose (plus 10% for error)
-	else if(weightDifference <= (doseWeight * 1.1))
+	else if(weightDifference <= fix16_mul(doseWeight, DOSE_TOLERANCE))
 		change = Weight_SmallChange;
 	// Larger than a dose means something potentially bad happened
 	else
@@ -87,11 +88,4 @@ Weight_Change Weight_CheckForChange(int atodval)
 
 /************************************************************************/
 /* Local  Implementation                                                */
-/************************************************************************/
-
-float calculateVoltage(int atodval)
-{
-    float q = AREF / MAX_ATODVAL; // 10 bit atod [1024]
-    float voltage = atodval * q; // min val (resting) 0.73V
-	return voltage;
-}
\ No newline at end of file
+/************************************************************************/
\ No newline at end of file
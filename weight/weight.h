@@ -6,12 +6,22 @@
  * Created: 2023-03-14
  * Author: Kia Skretteberg
  */
+#ifndef WEIGHTH
+#define WEIGHTH
+
+#include "../fixed/fixed.h"
 
 #define AREF 5.0
 #define MAX_ATODVAL 1024.0
 #define Weight_MAXN 10 // retrieved from https://www.uneotech.com/uploads/product_download/tw/Weight-10N%20ENG.pdf
 #define Weight_MINV 0.03 // Experimentally determined (voltage measured when no load) TODO: this value varies too much so set it kinda high and require pressing down
 
+// Weight_MINV as a raw atod value (voltage = atodval * AREF / MAX_ATODVAL), so checking for a load is one integer comparison
+#define Weight_MIN_ATODVAL ((int) (Weight_MINV * MAX_ATODVAL / AREF))
+// grams for every atod count: (atodval / MAX_ATODVAL) is the fraction of AREF, and AREF is the max force
+// g = N * (g/kg) / m/s^2, 1000.0 is the conversion factor for kg to g, 9.81 is gravity
+#define Weight_GRAMS_PER_ATODVAL FIX16_FROM_FLOAT((Weight_MAXN * 1000.0 / 9.81) / MAX_ATODVAL)
+
 
 typedef enum
 {
@@ -29,11 +39,17 @@ typedef enum
 	Weight_LoadUninitialized
 } Weight_LoadState;
 
-// Determine the weight (in grams) that the atodval represents
-float Weight_CalculateMass(int atodval);
+// Determine the weight (in grams, fixed point) that the atodval represents
+fix16_t Weight_CalculateMass(int atodval);
+
+// Determine how much a single dose should weigh (in grams, fixed point)
+fix16_t Weight_DetermineDosage(fix16_t startingWeight, int numDoses);
 
-// Determine how much a single dose should weigh
-float Weight_DetermineDosage(float startingWeight, int numDoses);
+// Set the atodval measured with nothing on the sensor (loads are measured from there)
+void Weight_SetTare(int atodval);
+
+// Get the atodval measured with nothing on the sensor
+int Weight_GetTare(void);
 
 // Check if a load is currently being indicated by the atodval measured
 Weight_LoadState Weight_CheckForLoad(int atodval);
@@ -41,3 +57,5 @@ Weight_LoadState Weight_CheckForLoad(int atodval);
 // Check if the atodval indicates a change in weight compared to previous weight
 // and how it changed in relation to the weight of a dose (was it roughly a dose [smallchange], or much more [largechange])
 Weight_Change Weight_CheckForChange(int atodval);
+
+#endif
\ No newline at end of file